@@ -13,5 +13,6 @@
 #include <nbtpp2/tags/tag_compound.hpp>
 #include <nbtpp2/tags/tag_int_array.hpp>
 #include <nbtpp2/tags/tag_long_array.hpp>
+#include <nbtpp2/number_list_tag.hpp>
 
 #endif //NBTPP2_ALL_TAGS_HPP
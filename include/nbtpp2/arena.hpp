@@ -0,0 +1,134 @@
+#ifndef NBTPP2_ARENA_HPP
+#define NBTPP2_ARENA_HPP
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/// Default size of the blocks an Arena allocates from, and the alignment of every block (a power of two)
+const std::size_t ARENA_BLOCK_SIZE = 65536;
+
+/**
+ * @class Arena
+ * @brief Monotonic allocator handing out memory from a few large blocks
+ *
+ * Memory is never returned to the arena on its own, all blocks are freed at once when the arena is destroyed.
+ * While an ArenaScope for an arena is active on a thread, every Tag created with new on that thread is placed in the
+ * arena and deleting it only runs its destructor. The blocks of all arenas are registered, so that deleting a tag can
+ * tell arena memory from heap memory without storing anything in the tag. Blocks are aligned to, and take a multiple
+ * of, ARENA_BLOCK_SIZE bytes, so that the check is a lock-free hash lookup of the block an address falls in (or a
+ * single atomic load while no arena exists).
+ */
+class Arena
+{
+    /// Frees a block allocated by {@link add_block}, and knows the size it was registered with
+    struct FreeBlock
+    {
+        std::size_t size;
+
+        void operator()(char *block) const;
+    };
+
+    using Block = std::unique_ptr<char[], FreeBlock>;
+
+    std::vector<Block> blocks;
+
+    /// Blocks of single allocations bigger than {@link block_size}
+    std::vector<Block> large_blocks;
+
+    /// Next free byte in the last block
+    char *cursor = nullptr;
+
+    /// Number of free bytes after {@link cursor}
+    std::size_t remaining = 0;
+
+    std::size_t block_size;
+
+    std::size_t used = 0;
+
+    /**
+     * @brief Allocate a block and register it as arena memory
+     * @param list List of blocks to add the block to
+     * @param size Size of the block (rounded up to a multiple of ARENA_BLOCK_SIZE)
+     * @return The block
+     */
+    char *add_block(std::vector<Block> &list, std::size_t size);
+
+public:
+    /**
+     * @param block_size Size of the blocks to allocate (allocations bigger than this get a block of their own). Every
+     * block takes at least ARENA_BLOCK_SIZE bytes of memory, so smaller sizes only limit how much of it is used.
+     */
+    explicit Arena(std::size_t block_size = ARENA_BLOCK_SIZE);
+
+    Arena(const Arena &) = delete;
+
+    Arena &operator=(const Arena &) = delete;
+
+    /// @brief Frees all blocks, and unregisters them as arena memory
+    ~Arena();
+
+    /**
+     * @brief Allocate memory from the arena
+     * @param size Number of bytes to allocate
+     * @param alignment Alignment of the memory (a power of two, at most alignof(std::max_align_t))
+     * @return Pointer to the allocated memory
+     */
+    void *allocate(std::size_t size, std::size_t alignment = alignof(std::max_align_t));
+
+    /**
+     * @brief Get the number of bytes handed out by the arena
+     * @return The number of bytes allocated from the arena
+     */
+    std::size_t bytes_used() const;
+
+    /**
+     * @brief Get the number of blocks the arena allocated
+     * @return The number of blocks
+     */
+    std::size_t block_count() const;
+
+    /**
+     * @brief Get the arena tags are currently allocated from on this thread
+     * @return The active arena, or nullptr if tags are allocated on the heap
+     */
+    static Arena *current();
+
+    /**
+     * @brief Check whether memory belongs to any arena
+     * @param ptr Pointer to the memory
+     * @return Whether @p ptr points into a block of a live arena
+     */
+    static bool owns(const void *ptr);
+
+    friend class ArenaScope;
+};
+
+/**
+ * @class ArenaScope
+ * @brief Makes an arena the active arena of the current thread for its lifetime
+ */
+class ArenaScope
+{
+    Arena *previous;
+
+public:
+    /**
+     * @param arena Arena to allocate tags from (nullptr allocates tags on the heap)
+     */
+    explicit ArenaScope(Arena *arena);
+
+    ArenaScope(const ArenaScope &) = delete;
+
+    ArenaScope &operator=(const ArenaScope &) = delete;
+
+    /// @brief Restores the previously active arena
+    ~ArenaScope();
+};
+
+}
+
+#endif //NBTPP2_ARENA_HPP
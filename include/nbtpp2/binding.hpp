@@ -0,0 +1,373 @@
+#ifndef NBTPP2_BINDING_HPP
+#define NBTPP2_BINDING_HPP
+
+#include <nbtpp2/key.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @brief Binding of a struct to a TAG_Compound, specialised for each bound struct with NBTPP2_BINDING
+ *
+ * A specialisation has a static fields() function returning a std::tuple of Fields.
+ * @tparam T Bound struct
+ */
+template<typename T>
+struct Binding;
+
+/**
+ * @brief Reads and writes values of a C++ type as one NBT tag type, specialised for every supported type
+ *
+ * Supported are std::int8_t and bool (TAG_Byte), std::int16_t, std::int32_t, std::int64_t, float, double,
+ * std::string, std::vector<std::int8_t>, std::vector<std::int32_t> and std::vector<std::int64_t> (the array tags),
+ * std::vector of any other supported type (TAG_List) and bound structs (TAG_Compound).
+ * @tparam T C++ type
+ */
+template<typename T>
+struct NbtValue;
+
+namespace detail
+{
+
+template<TagType Type, typename T, typename TUnsigned>
+struct NumberValue
+{
+    static constexpr TagType type = Type;
+
+    template<Endianness E>
+    static void read(BinaryReader &reader, T &value)
+    {
+        value = read_number<E, T, TUnsigned>(reader);
+    }
+
+    template<Endianness E>
+    static void write(const T &value, BinaryWriter &writer)
+    {
+        write_number<E, T, TUnsigned>(value, writer);
+    }
+};
+
+template<TagType Type, typename T, typename TUnsigned>
+struct ArrayValue
+{
+    static constexpr TagType type = Type;
+
+    template<Endianness E>
+    static void read(BinaryReader &reader, std::vector<T> &value)
+    {
+        auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+        value.resize(static_cast<std::size_t>(len < 0 ? 0 : len));
+        read_numbers<T, TUnsigned>(reader, value.data(), value.size(), E);
+    }
+
+    template<Endianness E>
+    static void write(const std::vector<T> &value, BinaryWriter &writer)
+    {
+        write_number<E, std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer);
+        write_numbers<T, TUnsigned>(value.data(), value.size(), writer, E);
+    }
+};
+
+template<typename Tuple, typename F, std::size_t... I>
+void for_each_field(const Tuple &fields, F &&f, std::index_sequence<I...>)
+{
+    int expand[] = {0, (f(std::get<I>(fields)), 0)...};
+    (void) expand;
+}
+
+/**
+ * @brief Call a function for every field of a bound struct, in declaration order
+ * @tparam T Bound struct
+ * @param f Function taking a Field
+ */
+template<typename T, typename F>
+void for_each_field(F &&f)
+{
+    const auto &fields = Binding<T>::fields();
+    using Tuple = std::decay_t<decltype(fields)>;
+    for_each_field(fields, std::forward<F>(f), std::make_index_sequence<std::tuple_size<Tuple>::value>{});
+}
+
+}
+
+/**
+ * @brief Codec for a std::vector as a TAG_List (also used by list_field() to force a list for number vectors)
+ * @tparam T Element type
+ */
+template<typename T>
+struct ListValue
+{
+    static constexpr TagType type = TagType::TagList;
+
+    template<Endianness E>
+    static void read(BinaryReader &reader, std::vector<T> &value)
+    {
+        auto element_type = read_tag_id(reader);
+        auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+        if (len <= 0) {
+            value.clear();
+            return;
+        }
+        if (element_type != NbtValue<T>::type)
+            throw std::runtime_error("expected a TAG_List of " + tag_type_to_string(NbtValue<T>::type) + ", got one of "
+                                     + tag_type_to_string(element_type));
+        value.resize(static_cast<std::size_t>(len));
+        for (auto &element : value) {
+            NbtValue<T>::template read<E>(reader, element);
+        }
+    }
+
+    template<Endianness E>
+    static void write(const std::vector<T> &value, BinaryWriter &writer)
+    {
+        write_tag_id(value.empty() ? TagType::TagEnd : NbtValue<T>::type, writer);
+        write_number<E, std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer);
+        for (const auto &element : value) {
+            NbtValue<T>::template write<E>(element, writer);
+        }
+    }
+};
+
+/**
+ * @brief Binding of a struct member to a compound entry
+ * @tparam ClassT Bound struct
+ * @tparam MemberT Type of the member
+ * @tparam CodecT Codec reading and writing the member (NbtValue<MemberT> unless overridden)
+ */
+template<typename ClassT, typename MemberT, typename CodecT = NbtValue<MemberT>>
+struct Field
+{
+    using Codec = CodecT;
+
+    /// Name of the compound entry
+    Key key;
+    MemberT ClassT::*member;
+};
+
+/**
+ * @brief Bind a struct member to a compound entry
+ * @param name Name of the compound entry
+ * @param member Pointer to the member
+ * @return The Field
+ */
+template<typename ClassT, typename MemberT>
+Field<ClassT, MemberT> field(const char *name, MemberT ClassT::*member)
+{
+    return Field<ClassT, MemberT>{Key{name}, member};
+}
+
+/**
+ * @brief Bind a std::vector member to a compound entry that is a TAG_List, also for vectors of numbers that would
+ * otherwise be read as array tags
+ * @param name Name of the compound entry
+ * @param member Pointer to the member
+ * @return The Field
+ */
+template<typename ClassT, typename T>
+Field<ClassT, std::vector<T>, ListValue<T>> list_field(const char *name, std::vector<T> ClassT::*member)
+{
+    return Field<ClassT, std::vector<T>, ListValue<T>>{Key{name}, member};
+}
+
+template<>
+struct NbtValue<std::int8_t>: detail::NumberValue<TagType::TagByte, std::int8_t, std::uint8_t>
+{
+};
+
+template<>
+struct NbtValue<std::int16_t>: detail::NumberValue<TagType::TagShort, std::int16_t, std::uint16_t>
+{
+};
+
+template<>
+struct NbtValue<std::int32_t>: detail::NumberValue<TagType::TagInt, std::int32_t, std::uint32_t>
+{
+};
+
+template<>
+struct NbtValue<std::int64_t>: detail::NumberValue<TagType::TagLong, std::int64_t, std::uint64_t>
+{
+};
+
+template<>
+struct NbtValue<float>: detail::NumberValue<TagType::TagFloat, float, std::uint32_t>
+{
+};
+
+template<>
+struct NbtValue<double>: detail::NumberValue<TagType::TagDouble, double, std::uint64_t>
+{
+};
+
+template<>
+struct NbtValue<bool>
+{
+    static constexpr TagType type = TagType::TagByte;
+
+    template<Endianness E>
+    static void read(BinaryReader &reader, bool &value)
+    {
+        value = read_number<E, std::int8_t, std::uint8_t>(reader) != 0;
+    }
+
+    template<Endianness E>
+    static void write(const bool &value, BinaryWriter &writer)
+    {
+        write_number<E, std::int8_t, std::uint8_t>(value ? 1 : 0, writer);
+    }
+};
+
+template<>
+struct NbtValue<std::string>
+{
+    static constexpr TagType type = TagType::TagString;
+
+    template<Endianness E>
+    static void read(BinaryReader &reader, std::string &value)
+    {
+        auto len = read_number<E, std::uint16_t, std::uint16_t>(reader);
+        value.resize(len);
+        reader.read(&value[0], len);
+    }
+
+    template<Endianness E>
+    static void write(const std::string &value, BinaryWriter &writer)
+    {
+        write_string<E>(value, writer);
+    }
+};
+
+template<>
+struct NbtValue<std::vector<std::int8_t>>: detail::ArrayValue<TagType::TagByteArray, std::int8_t, std::uint8_t>
+{
+};
+
+template<>
+struct NbtValue<std::vector<std::int32_t>>: detail::ArrayValue<TagType::TagIntArray, std::int32_t, std::uint32_t>
+{
+};
+
+template<>
+struct NbtValue<std::vector<std::int64_t>>: detail::ArrayValue<TagType::TagLongArray, std::int64_t, std::uint64_t>
+{
+};
+
+template<typename T>
+struct NbtValue<std::vector<T>>: ListValue<T>
+{
+};
+
+/// Bound structs, as a TAG_Compound
+template<typename T>
+struct NbtValue
+{
+    static constexpr TagType type = TagType::TagCompound;
+
+    /// Entries without a field are skipped, fields without an entry keep their value
+    template<Endianness E>
+    static void read(BinaryReader &reader, T &value)
+    {
+        while (true) {
+            auto id = read_tag_id(reader);
+            if (id == TagType::TagEnd) return;
+            auto name = read_key<E>(reader);
+            auto matched = false;
+            detail::for_each_field<T>([&](const auto &field)
+            {
+                using Codec = typename std::decay_t<decltype(field)>::Codec;
+                if (matched || field.key != name) return;
+                matched = true;
+                if (id != Codec::type)
+                    throw std::runtime_error("expected " + tag_type_to_string(Codec::type) + " for " + name.str()
+                                             + ", got " + tag_type_to_string(id));
+                Codec::template read<E>(reader, value.*field.member);
+            });
+            if (!matched) skip_tag(id, reader, E);
+        }
+    }
+
+    template<Endianness E>
+    static void write(const T &value, BinaryWriter &writer)
+    {
+        detail::for_each_field<T>([&](const auto &field)
+        {
+            using Codec = typename std::decay_t<decltype(field)>::Codec;
+            write_tag_id(Codec::type, writer);
+            write_string<E>(field.key, writer);
+            Codec::template write<E>(value.*field.member, writer);
+        });
+        write_tag_id(TagType::TagEnd, writer);
+    }
+};
+
+/**
+ * @brief Decode an NBT file straight into a bound struct, without building any tags
+ *
+ * The root tag must be a TAG_Compound; its name is skipped. Entries the binding does not name are skipped without
+ * being parsed, and members whose entry is missing keep their value.
+ * @param reader BinaryReader to read the file from
+ * @param endianness Endianness of the file
+ * @param value Struct to fill
+ * @throws std::runtime_error If the file is malformed or an entry does not have the tag type of its member
+ */
+template<typename T>
+void read_struct(BinaryReader &reader, Endianness endianness, T &value)
+{
+    if (read_tag_id(reader) != TagType::TagCompound) throw std::runtime_error("root tag is not a TAG_Compound");
+    skip_tag(TagType::TagString, reader, endianness);
+    if (endianness == Endianness::Big) NbtValue<T>::template read<Endianness::Big>(reader, value);
+    else NbtValue<T>::template read<Endianness::Little>(reader, value);
+}
+
+/**
+ * @brief Encode a bound struct straight into an NBT file, writing its fields in declaration order
+ * @param value Struct to write
+ * @param writer BinaryWriter to write the file to
+ * @param endianness Endianness to write the file in
+ * @param root_name Name of the root tag
+ */
+template<typename T>
+void write_struct(const T &value, BinaryWriter &writer, Endianness endianness, const std::string &root_name = "")
+{
+    write_tag_id(TagType::TagCompound, writer);
+    write_string(root_name, writer, endianness);
+    if (endianness == Endianness::Big) NbtValue<T>::template write<Endianness::Big>(value, writer);
+    else NbtValue<T>::template write<Endianness::Little>(value, writer);
+}
+
+}
+
+/**
+ * @brief Bind a struct to a TAG_Compound (use at global scope)
+ *
+ * @code
+ * NBTPP2_BINDING(Player,
+ *                nbtpp2::field("Health", &Player::health),
+ *                nbtpp2::field("Inventory", &Player::inventory))
+ * @endcode
+ * @param Type Fully qualified name of the struct
+ * @param ... Fields, made with nbtpp2::field() or nbtpp2::list_field()
+ */
+#define NBTPP2_BINDING(Type, ...) \
+    namespace nbtpp2 \
+    { \
+    template<> \
+    struct Binding<Type> \
+    { \
+        static const auto &fields() \
+        { \
+            static const auto bound = std::make_tuple(__VA_ARGS__); \
+            return bound; \
+        } \
+    }; \
+    }
+
+#endif //NBTPP2_BINDING_HPP
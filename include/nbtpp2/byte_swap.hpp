@@ -0,0 +1,80 @@
+#ifndef NBTPP2_BYTE_SWAP_HPP
+#define NBTPP2_BYTE_SWAP_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+#if defined(_MSC_VER)
+#   include <stdlib.h>
+#endif
+
+namespace nbtpp2
+{
+
+/**
+ * @brief Reverse the bytes of a number with the compiler's byte swap builtin
+ * @param value Number to reverse
+ * @return Reversed number
+ */
+inline std::uint8_t byte_swap(std::uint8_t value)
+{
+    return value;
+}
+
+/// @copydoc byte_swap(std::uint8_t)
+inline std::uint16_t byte_swap(std::uint16_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap16(value);
+#elif defined(_MSC_VER)
+    return _byteswap_ushort(value);
+#else
+    return static_cast<std::uint16_t>((value >> 8u) | (value << 8u));
+#endif
+}
+
+/// @copydoc byte_swap(std::uint8_t)
+inline std::uint32_t byte_swap(std::uint32_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(value);
+#elif defined(_MSC_VER)
+    return _byteswap_ulong(value);
+#else
+    return (value >> 24u) | ((value >> 8u) & 0xFF00u) | ((value << 8u) & 0xFF0000u) | (value << 24u);
+#endif
+}
+
+/// @copydoc byte_swap(std::uint8_t)
+inline std::uint64_t byte_swap(std::uint64_t value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(value);
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#else
+    return (static_cast<std::uint64_t>(byte_swap(static_cast<std::uint32_t>(value))) << 32u)
+           | byte_swap(static_cast<std::uint32_t>(value >> 32u));
+#endif
+}
+
+/**
+ * @brief Reverse the bytes of every number in an array
+ *
+ * Uses AVX2 or SSSE3 shuffles on x86 (picked at runtime from what the CPU supports), NEON on ARM, and byte swap
+ * builtins for the remainder and on other platforms.
+ * @param data Numbers to swap in place (do not need to be aligned)
+ * @param count Number of numbers
+ * @param size Size of each number in bytes (2, 4 or 8; other sizes are left as they are)
+ */
+void swap_bytes(void *data, std::size_t count, std::size_t size);
+
+/**
+ * @brief Get the name of the implementation swap_bytes() uses on this CPU
+ * @return "avx2", "ssse3", "neon" or "scalar"
+ */
+const char *swap_bytes_implementation();
+
+}
+
+#endif //NBTPP2_BYTE_SWAP_HPP
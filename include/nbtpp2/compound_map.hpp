@@ -0,0 +1,308 @@
+#ifndef NBTPP2_COMPOUND_MAP_HPP
+#define NBTPP2_COMPOUND_MAP_HPP
+
+#include <nbtpp2/key.hpp>
+
+#include <cstdint>
+#include <initializer_list>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace nbtpp2
+{
+
+class Tag;
+
+/// Number of entries from which a CompoundMap keeps a hash index
+const std::size_t COMPOUND_HASH_THRESHOLD = 16;
+
+/**
+ * @class CompoundMap
+ * @brief Map from names to tags, the contents of a TAG_Compound
+ *
+ * The entries are stored in one contiguous vector, sorted by name (like std::map) or in insertion order.
+ * Small maps are searched directly, maps with COMPOUND_HASH_THRESHOLD or more entries also keep an open-addressing
+ * hash index. Names are interned Keys: looking up a Key (or a string literal, which is interned first) compares
+ * pointers, looking up a std::string compares text and does not intern it.
+ * Entries of a tree read with ReadOptions::lazy may hold a LazyTag, which is replaced by the parsed tag whenever the
+ * entry is looked up or the map is iterated.
+ * @note Unlike std::map, inserting or erasing invalidates iterators, and the names of the entries must not be
+ * changed through an iterator
+ */
+class CompoundMap
+{
+public:
+    using key_type = Key;
+    using mapped_type = Tag *;
+    using value_type = std::pair<Key, Tag *>;
+    using size_type = std::size_t;
+    using iterator = std::vector<value_type>::iterator;
+    using const_iterator = std::vector<value_type>::const_iterator;
+
+    /**
+     * @enum Order
+     * @brief Iteration (and write) order of the entries
+     */
+    enum class Order
+    {
+        Sorted, ///< Sorted by name, like std::map
+        Insertion, ///< In the order the entries were inserted
+    };
+
+private:
+    /// Slot of the hash index
+    struct Slot
+    {
+        /// Hash of the name
+        std::uint32_t hash;
+        /// Index of the entry plus one (0 for an empty slot)
+        std::uint32_t entry;
+    };
+
+    /// Entries, mutable so that lookups can replace a LazyTag by its parsed tag
+    mutable std::vector<value_type> entries;
+
+    /**
+     * Whether each entry holds a LazyTag (empty while no entry was set with set_lazy()), kept apart from the tags so
+     * that looking up an entry never dereferences a tag the caller may have deleted already
+     */
+    mutable std::vector<bool> lazy;
+
+    /// Hash index (empty below COMPOUND_HASH_THRESHOLD entries), its size is a power of two
+    std::vector<Slot> index;
+
+    Order order = Order::Sorted;
+
+    /**
+     * @brief Find the position of an entry
+     * @param key Name of the entry
+     * @return Position of the entry in {@link entries}, or entries.size() if it does not exist
+     */
+    std::size_t locate(const Key &key) const;
+
+    /// @copydoc locate(const Key &) const
+    std::size_t locate(const std::string &key) const;
+
+    /**
+     * @brief Parse the tag of an entry if it is a LazyTag
+     * @param position Position of the entry (entries.size() is ignored)
+     * @return @p position
+     */
+    std::size_t resolve(std::size_t position) const;
+
+    /**
+     * @brief Insert a new entry (that does not exist yet) at its position
+     * @param key Name of the entry
+     * @param tag Tag of the entry
+     * @return Position of the new entry
+     */
+    std::size_t insert_new(Key key, Tag *tag);
+
+    /// @brief Rebuild {@link index} from {@link entries}
+    void rebuild_index();
+
+    /// @brief Sort {@link entries} (and their lazy flags) by name, keeping entries with equal names in their order
+    void sort_entries();
+
+    /**
+     * @brief Add an entry to {@link index} (which must have room)
+     * @param position Position of the entry
+     */
+    void index_entry(std::size_t position);
+
+public:
+    CompoundMap() = default;
+
+    /**
+     * @param entries Entries (later duplicates are ignored, like std::map does)
+     * @param order Order of the entries
+     */
+    CompoundMap(std::initializer_list<value_type> entries, Order order = Order::Sorted);
+
+    /**
+     * @brief Converts a std::map
+     * @param map Map to convert
+     */
+    CompoundMap(const std::map<std::string, Tag *> &map);
+
+    /**
+     * @brief Get the tag with a name, inserting an entry with a nullptr tag if it does not exist
+     * @param key Name of the tag
+     * @return Reference to the tag pointer
+     */
+    Tag *&operator[](const Key &key);
+
+    /// @copydoc operator[](const Key &)
+    Tag *&operator[](const std::string &key);
+
+    /// @copydoc operator[](const Key &)
+    Tag *&operator[](const char *key);
+
+    /**
+     * @brief Get the tag with a name
+     * @param key Name of the tag
+     * @return Reference to the tag pointer
+     * @throws std::out_of_range If there is no entry named @p key
+     */
+    Tag *&at(const Key &key);
+
+    /// @copydoc at(const Key &)
+    Tag *&at(const std::string &key);
+
+    /// @copydoc at(const Key &)
+    Tag *&at(const char *key);
+
+    /// @copydoc at(const Key &)
+    Tag *const &at(const Key &key) const;
+
+    /// @copydoc at(const Key &)
+    Tag *const &at(const std::string &key) const;
+
+    /// @copydoc at(const Key &)
+    Tag *const &at(const char *key) const;
+
+    /**
+     * @brief Find an entry
+     * @param key Name of the entry
+     * @return Iterator to the entry, or end() if it does not exist
+     */
+    iterator find(const Key &key);
+
+    /// @copydoc find(const Key &)
+    iterator find(const std::string &key);
+
+    /// @copydoc find(const Key &)
+    iterator find(const char *key);
+
+    /// @copydoc find(const Key &)
+    const_iterator find(const Key &key) const;
+
+    /// @copydoc find(const Key &)
+    const_iterator find(const std::string &key) const;
+
+    /// @copydoc find(const Key &)
+    const_iterator find(const char *key) const;
+
+    /**
+     * @brief Count the entries with a name
+     * @param key Name of the entry
+     * @return 1 if the entry exists, 0 otherwise
+     */
+    size_type count(const Key &key) const;
+
+    /// @copydoc count(const Key &) const
+    size_type count(const std::string &key) const;
+
+    /// @copydoc count(const Key &) const
+    size_type count(const char *key) const;
+
+    /**
+     * @brief Insert an entry if there is no entry with its name yet
+     * @param entry Entry to insert
+     * @return Iterator to the entry with the name, and whether @p entry was inserted
+     */
+    std::pair<iterator, bool> insert(value_type entry);
+
+    /**
+     * @brief Insert an entry if there is no entry with its name yet
+     * @param key Name of the entry
+     * @param tag Tag of the entry
+     * @return Iterator to the entry with the name, and whether the entry was inserted
+     */
+    std::pair<iterator, bool> emplace(Key key, Tag *tag);
+
+    /**
+     * @brief Set an entry to an unparsed tag, which is parsed when the entry is first looked up
+     * @param key Name of the entry (inserted if it does not exist yet)
+     * @param tag LazyTag of the entry
+     */
+    void set_lazy(const Key &key, Tag *tag);
+
+    /**
+     * @brief Add an entry at the end, without keeping the entries in order, indexed or unique
+     *
+     * Building a map of n entries with append() and one finish_append() takes O(n log n) at most, where inserting
+     * them one by one takes O(n²) when they do not come in order.
+     * @param key Name of the entry
+     * @param tag Tag of the entry
+     * @param unparsed Whether @p tag is a LazyTag (see set_lazy())
+     * @warning The map may only be used again after finish_append()
+     */
+    void append(Key key, Tag *tag, bool unparsed = false);
+
+    /**
+     * @brief Restore the order, uniqueness and index of the entries after append()
+     *
+     * Of entries with the same name, the first one's position is kept with the last one's tag, as if they were
+     * assigned with operator[].
+     * @return The tags of the entries that were replaced (not deleted)
+     */
+    std::vector<Tag *> finish_append();
+
+    /**
+     * @brief Remove an entry (without deleting its tag)
+     * @param key Name of the entry
+     * @return Number of entries removed
+     */
+    size_type erase(const Key &key);
+
+    /// @copydoc erase(const Key &)
+    size_type erase(const std::string &key);
+
+    /// @copydoc erase(const Key &)
+    size_type erase(const char *key);
+
+    /**
+     * @brief Remove an entry (without deleting its tag)
+     * @param position Iterator to the entry
+     * @return Iterator to the entry after the removed one
+     */
+    iterator erase(const_iterator position);
+
+    /// @brief Remove all entries (without deleting their tags)
+    void clear();
+
+    /**
+     * @brief Reserve memory for a number of entries
+     * @param size Number of entries
+     */
+    void reserve(size_type size);
+
+    size_type size() const;
+
+    bool empty() const;
+
+    /// @brief Get an iterator to the first entry, parsing the tags of all entries that are still unparsed
+    iterator begin();
+
+    iterator end();
+
+    /// @copydoc begin()
+    const_iterator begin() const;
+
+    const_iterator end() const;
+
+    /**
+     * @brief Get the entries as stored, without parsing unparsed entries
+     * @return The entries, which may hold LazyTags
+     */
+    const std::vector<value_type> &raw_entries() const;
+
+    /**
+     * @brief Get the order of the entries
+     * @return The order of the entries
+     */
+    Order get_order() const;
+
+    /**
+     * @brief Change the order of the entries (switching to Order::Sorted sorts them)
+     * @param new_order New order of the entries
+     */
+    void set_order(Order new_order);
+};
+
+}
+
+#endif //NBTPP2_COMPOUND_MAP_HPP
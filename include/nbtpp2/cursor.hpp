@@ -0,0 +1,193 @@
+#ifndef NBTPP2_CURSOR_HPP
+#define NBTPP2_CURSOR_HPP
+
+#include <nbtpp2/endianness.hpp>
+#include <nbtpp2/io.hpp>
+#include <nbtpp2/read_options.hpp>
+#include <nbtpp2/tag.hpp>
+#include <nbtpp2/tag_type.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @class NbtCursor
+ * @brief Pull parser over an NBT file, advanced tag by tag by the caller
+ *
+ * next() moves to the next tag of the compound or list the cursor is in (starting with the root tag). The payload of
+ * that tag can then be read with one of the read functions, entered with enter() if it is a compound or list, or
+ * left alone: tags that are not read are skipped without being parsed.
+ *
+ * @code
+ * NbtCursor cursor{reader, Endianness::Big};
+ * cursor.next();
+ * cursor.enter();
+ * while (cursor.next()) {
+ *     if (cursor.name() == "DataVersion") version = cursor.read_int();
+ * }
+ * @endcode
+ */
+class NbtCursor
+{
+    /// Compound or list the cursor is in
+    struct Frame
+    {
+        TagType container;
+        TagType element_type;
+        std::int32_t remaining;
+        bool finished;
+    };
+
+    BinaryReader &reader;
+    Endianness endianness;
+    std::vector<Frame> frames;
+
+    TagType current = TagType::TagEnd;
+    std::string current_name;
+
+    /// Whether the payload of {@link current} has not been read yet
+    bool pending = false;
+
+    /// Whether the root tag has been reached
+    bool started = false;
+
+    /**
+     * @brief Check that the current tag is unread and of the expected type, and mark it as read
+     * @param type Expected tag type
+     * @throws std::runtime_error If the current tag is of another type or has been read already
+     */
+    void consume(TagType type);
+
+    /*
+     * The public functions check the endianness once and call these, which are specialised on it like read_tag() so
+     * that no field read checks it again
+     */
+
+    /// @brief Move to the next tag, see next()
+    template<Endianness E>
+    bool advance();
+
+    /// @brief Read the element type and length of the list being entered into frame
+    template<Endianness E>
+    void read_list_header(Frame &frame);
+
+    /// @brief Read the payload of the current number tag, whose type has been consumed
+    template<Endianness E, typename NumberT, typename NumberTUnsigned>
+    NumberT read_value();
+
+    /// @brief Read the payload of the current array tag, whose type has been consumed
+    template<Endianness E, typename NumberT, typename NumberTUnsigned>
+    std::vector<NumberT> read_array();
+
+    /**
+     * @brief Consume the current tag and read its payload
+     * @param type Expected tag type
+     */
+    template<typename NumberT, typename NumberTUnsigned>
+    NumberT read_number_tag(TagType type);
+
+    /**
+     * @brief Consume the current tag and read its payload
+     * @param type Expected tag type
+     */
+    template<typename NumberT, typename NumberTUnsigned>
+    std::vector<NumberT> read_array_tag(TagType type);
+
+public:
+    /**
+     * @param reader BinaryReader to read the file from, positioned at the root tag
+     * @param endianness Endianness of the file
+     */
+    NbtCursor(BinaryReader &reader, Endianness endianness);
+
+    /**
+     * @brief Move to the next tag in the current compound or list, skipping the current tag if it was not read
+     * @return Whether there is a next tag (false at the end of the compound or list, which is then left with exit())
+     */
+    bool next();
+
+    /**
+     * @brief Get the type of the current tag
+     * @return The type of the current tag
+     */
+    TagType type() const;
+
+    /**
+     * @brief Get the name of the current tag
+     * @return The name of the current tag (empty for elements of a list)
+     */
+    const std::string &name() const;
+
+    /**
+     * @brief Get the number of compounds and lists the cursor is in
+     * @return The depth of the cursor (0 at the root tag)
+     */
+    std::size_t depth() const;
+
+    /**
+     * @brief Get the number of elements left in the list the cursor is in
+     * @return The number of elements that next() has not reached yet
+     * @throws std::runtime_error If the cursor is not in a list
+     */
+    std::int32_t remaining() const;
+
+    /// @brief Skip the payload of the current tag (next() does this implicitly)
+    void skip();
+
+    /**
+     * @brief Enter the current compound or list, so that next() moves through its entries
+     * @throws std::runtime_error If the current tag is not an unread compound or list
+     */
+    void enter();
+
+    /**
+     * @brief Leave the compound or list the cursor is in, skipping the rest of its entries
+     * @throws std::runtime_error If the cursor is at the root
+     */
+    void exit();
+
+    /// @brief Read the current tag, which must be an unread TAG_Byte
+    std::int8_t read_byte();
+
+    /// @brief Read the current tag, which must be an unread TAG_Short
+    std::int16_t read_short();
+
+    /// @brief Read the current tag, which must be an unread TAG_Int
+    std::int32_t read_int();
+
+    /// @brief Read the current tag, which must be an unread TAG_Long
+    std::int64_t read_long();
+
+    /// @brief Read the current tag, which must be an unread TAG_Float
+    float read_float();
+
+    /// @brief Read the current tag, which must be an unread TAG_Double
+    double read_double();
+
+    /// @brief Read the current tag, which must be an unread TAG_String
+    std::string read_string();
+
+    /// @brief Read the current tag, which must be an unread TAG_Byte_Array
+    std::vector<std::int8_t> read_byte_array();
+
+    /// @brief Read the current tag, which must be an unread TAG_Int_Array
+    std::vector<std::int32_t> read_int_array();
+
+    /// @brief Read the current tag, which must be an unread TAG_Long_Array
+    std::vector<std::int64_t> read_long_array();
+
+    /**
+     * @brief Read the current tag as a Tag
+     * @param options Options for reading the tag
+     * @return The read tag (owned by the caller)
+     */
+    Tag *read_tag(const ReadOptions &options = ReadOptions{});
+};
+
+}
+
+#endif //NBTPP2_CURSOR_HPP
@@ -16,11 +16,27 @@ enum class Endianness
     Little, ///< Little-endian
 };
 
+// Known at compile time on compilers reporting the byte order and on Windows, which is always little-endian
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#   define NBTPP2_SYSTEM_ENDIANNESS Endianness::Big
+#elif (defined(__BYTE_ORDER__) && defined(__ORDER_LITTLE_ENDIAN__) && __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__) \
+    || defined(_WIN32)
+#   define NBTPP2_SYSTEM_ENDIANNESS Endianness::Little
+#endif
+
+#if defined(NBTPP2_SYSTEM_ENDIANNESS)
+/**
+ * @var SYSTEM_ENDIANNESS
+ * @brief System endianness, a compile-time constant so that checks against it are folded away
+ */
+constexpr Endianness SYSTEM_ENDIANNESS = NBTPP2_SYSTEM_ENDIANNESS;
+#else
 /**
  * @var SYSTEM_ENDIANNESS
  * @brief Calculates system endianness statically
  */
 extern const Endianness SYSTEM_ENDIANNESS;
+#endif
 
 }
 
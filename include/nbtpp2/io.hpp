@@ -2,8 +2,13 @@
 #define NBTPP2_IO_HPP
 
 #include <cstdint>
+#include <deque>
+#include <future>
 #include <istream>
+#include <memory>
 #include <ostream>
+#include <string>
+#include <vector>
 #include <zlib.h>
 #include <nbtpp2/converters.hpp>
 
@@ -19,18 +24,65 @@
 #define _CRT_SECURE_NO_DEPRECATE
 #endif
 
+struct ZSTD_CCtx_s;
+struct ZSTD_DCtx_s;
+struct LZ4F_cctx_s;
+struct LZ4F_dctx_s;
+
 namespace nbtpp2
 {
 
 const unsigned int DEFLATE_LEVEL = 5;
 
+const int ZSTD_LEVEL = 3;
+
+const int LZ4_LEVEL = 0;
+
 const unsigned int CHUNK = 16384;
 
+const std::size_t PARALLEL_BLOCK_SIZE = 131072;
+
+/**
+ * @enum DeflateStrategy
+ * @brief zlib deflate strategy
+ */
+enum class DeflateStrategy: std::int32_t
+{
+    Default = Z_DEFAULT_STRATEGY, ///< Normal deflate
+    Filtered = Z_FILTERED, ///< Favour Huffman coding over string matching, for data with small random variations
+    Rle = Z_RLE, ///< Only match runs of the same byte (fast, good for PNG-like data)
+    HuffmanOnly = Z_HUFFMAN_ONLY, ///< No string matching at all
+};
+
+/**
+ * @struct WriteOptions
+ * @brief Options for gzip/zlib compressed writes
+ */
+struct WriteOptions
+{
+    /// Deflate level (0-9, or Z_DEFAULT_COMPRESSION)
+    std::int32_t level = DEFLATE_LEVEL;
+    /// Deflate strategy
+    DeflateStrategy strategy = DeflateStrategy::Default;
+    /// Base two logarithm of the deflate window size (9-15)
+    std::int32_t window_bits = MAX_WBITS;
+    /// Memory used for the internal compression state (1-9)
+    std::int32_t mem_level = 8;
+};
+
+// Throw std::runtime_error if options are outside the ranges documented in WriteOptions
+void validate_write_options(const WriteOptions &options);
+
+class ThreadPool;
+
 class BinaryReader
 {
 public:
     // Read buffer from stream
     virtual void read(char *buf, std::uint32_t n) = 0;
+
+    // Advance past n bytes (reads them into a scratch buffer unless the reader can seek)
+    virtual void skip(std::size_t n);
 };
 
 class BinaryWriter
@@ -68,6 +120,9 @@ public:
     explicit FileReader(FILE *file);
 
     void read(char *buf, std::uint32_t n) override;
+
+    // Seek past n bytes, falling back to reading them if the file is not seekable
+    void skip(std::size_t n) override;
 };
 
 class FileWriter: public BinaryWriter
@@ -80,6 +135,115 @@ public:
     void write(const char *buf, std::uint32_t n) override;
 };
 
+class BufferReader: public BinaryReader
+{
+protected:
+    const char *data = nullptr;
+    std::size_t data_size = 0;
+    std::size_t pos = 0;
+
+    BufferReader() = default;
+
+public:
+    // Read from size bytes at data (not copied, must outlive the reader)
+    BufferReader(const char *data, std::size_t size);
+
+    explicit BufferReader(const std::vector<char> &buf);
+
+    void read(char *buf, std::uint32_t n) override;
+
+    // Advance past n bytes without touching them
+    void skip(std::size_t n) override;
+
+    // Get a pointer to the next n bytes in the buffer and advance past them
+    const char *read_ptr(std::uint32_t n);
+
+    // Get the start of the buffer
+    const char *buffer() const;
+
+    std::size_t position() const;
+
+    std::size_t size() const;
+};
+
+// BufferReader sharing ownership of its buffer, so tags can keep referring to the buffer after reading
+class SharedBufferReader: public BufferReader
+{
+    std::shared_ptr<const void> owner;
+
+public:
+    // Read from size bytes at data, which owner keeps alive
+    SharedBufferReader(std::shared_ptr<const void> owner, const char *data, std::size_t size);
+
+    const std::shared_ptr<const void> &get_owner() const;
+};
+
+class BufferWriter: public BinaryWriter
+{
+    std::vector<char> buf;
+
+public:
+    BufferWriter() = default;
+
+    // Reserve capacity bytes up front
+    explicit BufferWriter(std::size_t capacity);
+
+    void write(const char *data, std::uint32_t n) override;
+
+    const char *data() const;
+
+    std::size_t size() const;
+
+    std::vector<char> &buffer();
+
+    // Empty the buffer, keeping its capacity for reuse
+    void clear();
+};
+
+// Writes into a caller-provided buffer of fixed size by bumping a pointer, throwing when it runs out of room
+class SpanWriter final: public BinaryWriter
+{
+    char *buf;
+    std::size_t buf_size;
+    std::size_t pos = 0;
+
+public:
+    SpanWriter(char *data, std::size_t size);
+
+    void write(const char *data, std::uint32_t n) override;
+
+    std::size_t position() const;
+};
+
+// Discards what is written, only counting the bytes
+class CountingWriter final: public BinaryWriter
+{
+    std::size_t count = 0;
+
+public:
+    void write(const char *data, std::uint32_t n) override;
+
+    std::size_t size() const;
+};
+
+class MmapReader: public BufferReader
+{
+#if defined(_WIN32)
+    void *file_handle = nullptr;
+    void *mapping_handle = nullptr;
+#endif
+
+public:
+    // Map the whole file at path read-only
+    explicit MmapReader(const std::string &path);
+
+    MmapReader(const MmapReader &) = delete;
+
+    MmapReader &operator=(const MmapReader &) = delete;
+
+    ~MmapReader();
+};
+
 class GzReader: public BinaryReader
 {
     gzFile file;
@@ -88,6 +252,9 @@ public:
     explicit GzReader(gzFile file);
 
     void read(char *buf, std::uint32_t n) override;
+
+    // Inflate past n bytes without copying them out
+    void skip(std::size_t n) override;
 };
 
 class GzWriter: public BinaryWriter
@@ -104,18 +271,24 @@ class ZlibReader: public BinaryReader
 {
     FILE *file;
     z_stream stream = z_stream{};
-    std::uint8_t buf[CHUNK] = {0};
-    std::size_t buf_used = 0;
-    std::size_t file_size = 0;
-    std::size_t file_read = 0;
     std::int32_t ret = 0;
+    // Compressed input window, consumed through stream.next_in/avail_in
+    std::uint8_t in[CHUNK] = {0};
+    // Inflated output window, consumed from out_pos up to out_end
+    std::uint8_t out[CHUNK] = {0};
+    std::size_t out_pos = 0;
+    std::size_t out_end = 0;
 
-    void buffer_shift_back(std::size_t amount);
+    // Inflate into dest, refilling the input window from the file when it runs dry
+    std::size_t inflate_into(std::uint8_t *dest, std::size_t n);
 
 public:
-    explicit ZlibReader(FILE *file);
+    // Inflate from file, which does not need to be seekable (window_bits + 16 reads gzip instead of zlib)
+    explicit ZlibReader(FILE *file, std::int32_t window_bits = MAX_WBITS);
+
+    ZlibReader(const ZlibReader &) = delete;
 
-    void read_buf();
+    ZlibReader &operator=(const ZlibReader &) = delete;
 
     void read(char *data, std::uint32_t n) override;
 
@@ -129,18 +302,214 @@ class ZlibWriter: public BinaryWriter
     z_stream stream = z_stream{};
     std::uint8_t in[CHUNK] = {0};
     std::uint8_t out[CHUNK] = {0};
-    FILE *dest;
+    FileWriter file_writer{nullptr};
+    BinaryWriter *dest;
+
+    void init(const WriteOptions &options, bool gzip);
 
     void write_internal(const char *buf, std::uint32_t n, bool flush);
 
 public:
     explicit ZlibWriter(FILE *dest, std::int32_t level);
 
+    // Deflate into another writer (window_bits + 16 writes a gzip wrapper instead of a zlib wrapper)
+    ZlibWriter(BinaryWriter &dest, std::int32_t level, std::int32_t window_bits = MAX_WBITS);
+
+    // Deflate with options, with a gzip wrapper instead of a zlib wrapper if gzip is set
+    ZlibWriter(FILE *dest, const WriteOptions &options, bool gzip = false);
+
+    ZlibWriter(BinaryWriter &dest, const WriteOptions &options, bool gzip = false);
+
+    ZlibWriter(const ZlibWriter &) = delete;
+
+    ZlibWriter &operator=(const ZlibWriter &) = delete;
+
     void write(const char *buf, std::uint32_t n) override;
 
     ~ZlibWriter();
 };
 
+class ParallelGzWriter: public BinaryWriter
+{
+    struct Block
+    {
+        std::vector<char> deflated;
+        uLong crc = 0;
+        std::size_t size = 0;
+    };
+
+    FileWriter file_writer{nullptr};
+    BinaryWriter *dest;
+    WriteOptions options;
+    std::size_t block_size;
+    std::unique_ptr<ThreadPool> pool;
+    // Input block being filled and the block before it (used as deflate dictionary)
+    std::shared_ptr<std::vector<char>> current;
+    std::shared_ptr<std::vector<char>> previous;
+    // Blocks being deflated, in output order
+    std::deque<std::future<Block>> pending;
+    uLong crc;
+    std::uint32_t total_size = 0;
+    bool finished = false;
+
+    void write_header();
+
+    void submit_block(bool last);
+
+    // Wait for the oldest pending block and write it out
+    void write_block();
+
+public:
+    // Deflate blocks of block_size bytes on threads workers (0 uses all hardware threads) into a single gzip member,
+    // which is completed by finish()
+    explicit ParallelGzWriter(FILE *dest, const WriteOptions &options = WriteOptions{}, unsigned threads = 0,
+                              std::size_t block_size = PARALLEL_BLOCK_SIZE);
+
+    explicit ParallelGzWriter(BinaryWriter &dest, const WriteOptions &options = WriteOptions{}, unsigned threads = 0,
+                              std::size_t block_size = PARALLEL_BLOCK_SIZE);
+
+    ParallelGzWriter(const ParallelGzWriter &) = delete;
+
+    ParallelGzWriter &operator=(const ParallelGzWriter &) = delete;
+
+    void write(const char *buf, std::uint32_t n) override;
+
+    // Deflate the last block and write the gzip trailer, rethrowing any error of the workers
+    void finish();
+
+    // Waits for the pending blocks without writing them; the output is incomplete unless finish() was called
+    ~ParallelGzWriter();
+};
+
+// Base for readers decompressing from a file or from memory through an output window
+class DecompressingReader: public BinaryReader
+{
+    FILE *file = nullptr;
+    std::uint8_t in[CHUNK] = {0};
+    std::uint8_t out[CHUNK] = {0};
+    std::size_t out_pos = 0;
+    std::size_t out_end = 0;
+
+protected:
+    // Compressed input not consumed yet
+    const std::uint8_t *in_ptr = nullptr;
+    std::size_t in_avail = 0;
+
+    explicit DecompressingReader(FILE *file);
+
+    DecompressingReader(const char *data, std::size_t size);
+
+    // Decompress at most n bytes from in_ptr/in_avail into dest, advancing in_ptr, and return the amount produced
+    virtual std::size_t decompress(std::uint8_t *dest, std::size_t n) = 0;
+
+public:
+    DecompressingReader(const DecompressingReader &) = delete;
+
+    DecompressingReader &operator=(const DecompressingReader &) = delete;
+
+    void read(char *data, std::uint32_t n) override;
+
+    virtual ~DecompressingReader() = default;
+};
+
+// Reads a Zstandard frame (throws if nbtpp2 was built without NBTPP2_WITH_ZSTD)
+class ZstdReader: public DecompressingReader
+{
+    ZSTD_DCtx_s *ctx = nullptr;
+
+    void init();
+
+protected:
+    std::size_t decompress(std::uint8_t *dest, std::size_t n) override;
+
+public:
+    explicit ZstdReader(FILE *file);
+
+    ZstdReader(const char *data, std::size_t size);
+
+    ~ZstdReader() override;
+};
+
+// Writes a Zstandard frame (throws if nbtpp2 was built without NBTPP2_WITH_ZSTD)
+class ZstdWriter: public BinaryWriter
+{
+    ZSTD_CCtx_s *ctx = nullptr;
+    std::uint8_t out[CHUNK] = {0};
+    FileWriter file_writer{nullptr};
+    BinaryWriter *dest;
+
+    void init(std::int32_t level);
+
+    void write_internal(const char *buf, std::uint32_t n, bool flush);
+
+public:
+    // Throw if nbtpp2 was built without support for this compression
+    static void require_support();
+
+    explicit ZstdWriter(FILE *dest, std::int32_t level = ZSTD_LEVEL);
+
+    explicit ZstdWriter(BinaryWriter &dest, std::int32_t level = ZSTD_LEVEL);
+
+    ZstdWriter(const ZstdWriter &) = delete;
+
+    ZstdWriter &operator=(const ZstdWriter &) = delete;
+
+    void write(const char *buf, std::uint32_t n) override;
+
+    ~ZstdWriter();
+};
+
+// Reads an LZ4 frame (throws if nbtpp2 was built without NBTPP2_WITH_LZ4)
+class Lz4Reader: public DecompressingReader
+{
+    LZ4F_dctx_s *ctx = nullptr;
+
+    void init();
+
+protected:
+    std::size_t decompress(std::uint8_t *dest, std::size_t n) override;
+
+public:
+    explicit Lz4Reader(FILE *file);
+
+    Lz4Reader(const char *data, std::size_t size);
+
+    ~Lz4Reader() override;
+};
+
+// Writes an LZ4 frame (throws if nbtpp2 was built without NBTPP2_WITH_LZ4)
+class Lz4Writer: public BinaryWriter
+{
+    LZ4F_cctx_s *ctx = nullptr;
+    std::vector<char> in;
+    std::vector<char> out;
+    FileWriter file_writer{nullptr};
+    BinaryWriter *dest;
+
+    void init(std::int32_t level);
+
+    void flush_input();
+
+public:
+    // Throw if nbtpp2 was built without support for this compression
+    static void require_support();
+
+    explicit Lz4Writer(FILE *dest, std::int32_t level = LZ4_LEVEL);
+
+    explicit Lz4Writer(BinaryWriter &dest, std::int32_t level = LZ4_LEVEL);
+
+    Lz4Writer(const Lz4Writer &) = delete;
+
+    Lz4Writer &operator=(const Lz4Writer &) = delete;
+
+    void write(const char *buf, std::uint32_t n) override;
+
+    ~Lz4Writer();
+};
+
+// Inflate a complete zlib or gzip stream of size bytes at data into out (sized from the gzip trailer when possible)
+void inflate_buffer(const char *data, std::size_t size, std::vector<char> &out);
+
 }
 
 #endif //NBTPP2_IO_HPP
@@ -0,0 +1,171 @@
+#ifndef NBTPP2_KEY_HPP
+#define NBTPP2_KEY_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+namespace nbtpp2
+{
+
+/**
+ * @brief Hash a name (32-bit FNV-1a)
+ * @param data Characters of the name
+ * @param size Number of characters
+ * @return Hash of the name
+ */
+std::uint32_t key_hash(const char *data, std::size_t size);
+
+/**
+ * @class Key
+ * @brief Handle to an interned compound name
+ *
+ * All keys with the same text share one copy of it in a global, thread-safe pool, so comparing two keys is a pointer
+ * comparison and copying a key never allocates. A key can be used much like a const std::string (size(), c_str(),
+ * begin(), concatenation, streaming); str() gives the string itself.
+ * @warning The pool is never freed: every distinct name that was ever read from a file or made into a Key stays
+ * interned until the program exits. Its size is bounded by the number of distinct names, not by the number of files,
+ * but a long-running program reading untrusted files with arbitrary names grows without bound. Such programs should
+ * watch interned_key_count() and interned_key_bytes(), or parse that input with visit() or NbtCursor, which do not
+ * intern names.
+ */
+class Key
+{
+public:
+    /// An interned name
+    struct Record
+    {
+        std::string text;
+        std::uint32_t hash;
+    };
+
+private:
+    const Record *record;
+
+public:
+    /// @brief The empty name
+    Key();
+
+    /**
+     * @param text Name to intern
+     */
+    Key(const std::string &text);
+
+    /**
+     * @param text Name to intern (null-terminated)
+     */
+    Key(const char *text);
+
+    /**
+     * @param data Characters of the name to intern
+     * @param size Number of characters
+     */
+    Key(const char *data, std::size_t size);
+
+    /**
+     * @brief Get the text of the key
+     * @return The text of the key
+     */
+    const std::string &str() const
+    { return record->text; }
+
+    operator const std::string &() const
+    { return record->text; }
+
+    std::size_t size() const
+    { return record->text.size(); }
+
+    std::size_t length() const
+    { return record->text.length(); }
+
+    bool empty() const
+    { return record->text.empty(); }
+
+    const char *c_str() const
+    { return record->text.c_str(); }
+
+    const char *data() const
+    { return record->text.data(); }
+
+    std::string::const_iterator begin() const
+    { return record->text.begin(); }
+
+    std::string::const_iterator end() const
+    { return record->text.end(); }
+
+    const char &operator[](std::size_t pos) const
+    { return record->text[pos]; }
+
+    /**
+     * @brief Get the hash of the key (key_hash() of its text)
+     * @return The hash of the key
+     */
+    std::uint32_t hash() const
+    { return record->hash; }
+
+    friend bool operator==(const Key &a, const Key &b)
+    { return a.record == b.record; }
+
+    friend bool operator!=(const Key &a, const Key &b)
+    { return a.record != b.record; }
+
+    friend bool operator<(const Key &a, const Key &b)
+    { return a.record != b.record && a.record->text < b.record->text; }
+
+    friend bool operator==(const Key &a, const std::string &b)
+    { return a.record->text == b; }
+
+    friend bool operator==(const std::string &a, const Key &b)
+    { return b == a; }
+
+    friend bool operator!=(const Key &a, const std::string &b)
+    { return !(a == b); }
+
+    friend bool operator!=(const std::string &a, const Key &b)
+    { return !(b == a); }
+
+    friend bool operator==(const Key &a, const char *b)
+    { return a.record->text == b; }
+
+    friend bool operator==(const char *a, const Key &b)
+    { return b == a; }
+
+    friend bool operator!=(const Key &a, const char *b)
+    { return !(a == b); }
+
+    friend bool operator!=(const char *a, const Key &b)
+    { return !(b == a); }
+
+    friend std::string operator+(const Key &a, const std::string &b)
+    { return a.record->text + b; }
+
+    friend std::string operator+(const std::string &a, const Key &b)
+    { return a + b.record->text; }
+
+    friend std::string operator+(const Key &a, const char *b)
+    { return a.record->text + b; }
+
+    friend std::string operator+(const char *a, const Key &b)
+    { return a + b.record->text; }
+
+    friend std::ostream &operator<<(std::ostream &stream, const Key &key)
+    { return stream << key.record->text; }
+};
+
+/**
+ * @brief Get the number of names in the key pool
+ * @return The number of interned names
+ */
+std::size_t interned_key_count();
+
+/**
+ * @brief Get the total length of the names in the key pool
+ * @return The number of characters of all interned names
+ */
+std::size_t interned_key_bytes();
+
+}
+
+#endif //NBTPP2_KEY_HPP
@@ -0,0 +1,71 @@
+#ifndef NBTPP2_LAZY_TAG_HPP
+#define NBTPP2_LAZY_TAG_HPP
+
+#include <nbtpp2/tag.hpp>
+#include <nbtpp2/read_options.hpp>
+
+#include <memory>
+
+namespace nbtpp2
+{
+
+/**
+ * @class LazyTag
+ * @brief Unparsed tag in a tree read with ReadOptions::lazy
+ *
+ * Stands in for a compound entry whose payload has only been skipped over. It identifies as the tag it stands in for,
+ * and CompoundMap replaces it by the parsed tag as soon as the entry is accessed. Writing a LazyTag copies its
+ * payload as-is when the endianness matches.
+ */
+class LazyTag: public Tag
+{
+    /// Keeps the buffer {@link data} points into alive
+    std::shared_ptr<const void> owner;
+
+    const char *data;
+    std::size_t size;
+    Endianness endianness;
+    ReadOptions options;
+
+public:
+    /**
+     * @param type Tag type of the unparsed tag
+     * @param owner Owner of the buffer @p data points into
+     * @param data Payload of the tag
+     * @param size Size of the payload in bytes
+     * @param endianness Endianness of the payload
+     * @param options Options to parse the payload with
+     */
+    LazyTag(TagType type, std::shared_ptr<const void> owner, const char *data, std::size_t size, Endianness endianness,
+            const ReadOptions &options);
+
+    /**
+     * @brief Write the payload of the tag, parsing it first if @p endianness differs from the payload's
+     * @param writer BinaryWriter to write to
+     * @param endianness Endianness to write the tag in
+     */
+    void write(BinaryWriter &writer, Endianness endianness) override;
+
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override;
+
+    /**
+     * @brief Parse the tag
+     * @return The parsed tag (owned by the caller)
+     */
+    Tag *materialize() const;
+
+    /**
+     * @brief Read a tag, as a LazyTag if it is a compound, list or array and @p reader is a SharedBufferReader
+     * @param type Tag type (tag id) of the tag to read
+     * @param reader BinaryReader to read from
+     * @param endianness Endianness to read the tag in
+     * @param options Options for reading the tag
+     * @return Resulting tag as Tag *
+     */
+    static Tag *read(TagType type, BinaryReader &reader, Endianness endianness, const ReadOptions &options);
+};
+
+}
+
+#endif //NBTPP2_LAZY_TAG_HPP
@@ -2,10 +2,14 @@
 #define NBTPP2_NBT_FILE_HPP
 
 #include <nbtpp2/tags/tag_compound.hpp>
+#include <nbtpp2/arena.hpp>
 #include <nbtpp2/io.hpp>
+#include <nbtpp2/read_options.hpp>
+#include <nbtpp2/visitor.hpp>
 
 #include <fstream>
 #include <memory>
+#include <vector>
 
 /// @brief The namespace where all nbtpp2 functions and classes are located
 namespace nbtpp2
@@ -28,14 +32,22 @@ public:
         Gzip, ///< Uses gzip compression
         Zlib, ///< Uses zlib compression
         None, ///< Disables compression
+        Zstd, ///< Uses Zstandard compression (requires nbtpp2 to be built with NBTPP2_WITH_ZSTD, not readable by Minecraft)
+        Lz4, ///< Uses LZ4 frame compression (requires nbtpp2 to be built with NBTPP2_WITH_LZ4, not readable by Minecraft)
     };
 private:
-    /// The root tag
+    /// The root tag (when read with ReadOptions::arena, it also owns the arena its tags live in)
     std::shared_ptr<Tag> root;
 
     /// The compression used for writing the NbtFile
     Compression write_compression = Compression::None;
 
+    /// The number of threads used for gzip compression when writing the NbtFile
+    unsigned write_threads = 1;
+
+    /// The options the NbtFile is read with
+    ReadOptions read_options;
+
     /**
      * @brief Reads reader contents to {@link root_name} and {@link root}
      * @param reader BinaryReader to read from
@@ -44,18 +56,52 @@ private:
     void read(BinaryReader &reader, nbtpp2::Endianness endianness);
 
     /**
-     * @brief Reads gzip-compressed file
-     * @param path Path to read from
-     * @param endianness Endianness to read from the istream in
+     * @brief Makes {@link root} share ownership of the arena its tags were read into
+     *
+     * The arena is then only freed after the tree, however the NbtFile is assigned, copied or destroyed.
+     * @param arena Arena the tags of {@link root} were read into (nothing happens if nullptr)
      */
-    void read_gzip(const std::string &path, nbtpp2::Endianness endianness);
+    void keep_arena(std::shared_ptr<Arena> arena);
 
     /**
-     * @brief Reads zlib-compressed file
+     * @brief Opens an NBT file with the BinaryReader for its compression
+     * @tparam F Callable taking a BinaryReader &
      * @param path Path to read from
-     * @param endianness Endianness to read from the istream in
+     * @param compression Compression used in the file (Compression::Detect to detect it)
+     * @param f Called with the reader
+     * @return The compression of the file
+     */
+    template<typename F>
+    static Compression with_reader(const std::string &path, Compression compression, F f);
+
+    /**
+     * @brief Detects the compression of an NBT file from its magic bytes
+     * @param magic The first bytes of the file
+     * @param size The number of bytes available at @p magic (at most 4 are used)
+     * @return The detected compression (Compression::None if nothing matched)
+     */
+    static Compression detect_compression(const char *magic, std::size_t size);
+
+    /**
+     * @brief Reads an in-memory NBT file
+     * @param data Pointer to the file contents
+     * @param size Size of the file contents in bytes
+     * @param endianness Endianness to read the buffer in
+     * @param compression Compression used in the buffer
      */
-    void read_zlib(const std::string &path, nbtpp2::Endianness endianness);
+    void read_buffer(const char *data, std::size_t size, nbtpp2::Endianness endianness, Compression compression);
+
+    /**
+     * @brief Reads an in-memory NBT file through a SharedBufferReader, so that lazily read tags can refer to it
+     * @param owner Owner of @p data (if nullptr, @p data is copied when it needs to outlive the call)
+     * @param data Pointer to the file contents
+     * @param size Size of the file contents in bytes
+     * @param endianness Endianness to read the buffer in
+     * @param compression Compression used in the buffer
+     * @note Zstandard and LZ4 compressed files are read eagerly
+     */
+    void read_shared(std::shared_ptr<const void> owner, const char *data, std::size_t size,
+                     nbtpp2::Endianness endianness, Compression compression);
 
     /**
      * @brief Writes {@link root_name} and {@link root} to a BinaryWriter
@@ -68,15 +114,26 @@ private:
      * @brief Writes file as gzip-compressed NBT file
      * @param path Path to write to
      * @param endianness Endianness to write in
+     * @param options Deflate options
      */
-    void write_gzip(const std::string &path, nbtpp2::Endianness endianness);
+    void write_gzip(const std::string &path, nbtpp2::Endianness endianness, const WriteOptions &options);
 
     /**
      * @brief Writes file as zlib-compressed NBT file
      * @param path Path to write to
      * @param endianness Endianness to write in
+     * @param options Deflate options
      */
-    void write_zlib(const std::string &path, nbtpp2::Endianness endianness);
+    void write_zlib(const std::string &path, nbtpp2::Endianness endianness, const WriteOptions &options);
+
+    /**
+     * @brief Writes file compressed with a BinaryWriter that compresses into a FILE *
+     * @tparam WriterT Compressing writer type
+     * @param path Path to write to
+     * @param endianness Endianness to write in
+     */
+    template<typename WriterT>
+    void write_compressed(const std::string &path, nbtpp2::Endianness endianness);
 
 public:
     /// The name of the root TAG_Compound. Used for writing to a file.
@@ -87,8 +144,22 @@ public:
      * @param path Path of the NBT file to open
      * @param endianness Endianness of the NBT file to open
      * @param compression Compression used in the file (detected automatically by default)
+     * @param options Options for reading the file
+     * @note Uncompressed files are memory-mapped and parsed straight from the mapping
      */
-    NbtFile(const std::string &path, nbtpp2::Endianness endianness, Compression compression = Compression::Detect);
+    NbtFile(const std::string &path, nbtpp2::Endianness endianness, Compression compression = Compression::Detect,
+            const ReadOptions &options = ReadOptions{});
+
+    /**
+     * @brief Construct an NbtFile by reading from an in-memory NBT file
+     * @param data Pointer to the file contents (only used during construction)
+     * @param size Size of the file contents in bytes
+     * @param endianness Endianness of the NBT file
+     * @param compression Compression used in the buffer (detected automatically by default)
+     * @param options Options for reading the buffer (ReadOptions::in_memory has no effect)
+     */
+    NbtFile(const char *data, std::size_t size, nbtpp2::Endianness endianness, Compression compression = Compression::Detect,
+            const ReadOptions &options = ReadOptions{});
 
     /**
      * @brief Construct an NbtFile with a root and root name
@@ -104,20 +175,66 @@ public:
      */
     explicit NbtFile(std::string root_name = "");
 
+    /**
+     * @brief Stream an NBT file to a visitor without building a tree of tags
+     * @param path Path of the NBT file to read
+     * @param endianness Endianness of the NBT file
+     * @param visitor Visitor receiving the contents of the file
+     * @param compression Compression used in the file (detected automatically by default)
+     * @see nbtpp2::visit
+     */
+    static void visit(const std::string &path, nbtpp2::Endianness endianness, NbtVisitor &visitor,
+                      Compression compression = Compression::Detect);
+
     /**
      * @brief Write {@link root_name} with {@link root} TAG_Compound to @p path
      * @param path Path to write the NbtFile to
      * @param endianness Endianness to write the NbtFile in
      * @param compression The compression used for compressing the NbtFile (compression set by the constructor)
+     * @param options Deflate options (only used for gzip and zlib compression)
+     */
+    void write(const std::string &path, nbtpp2::Endianness endianness, Compression compression = Compression::Detect,
+               const WriteOptions &options = WriteOptions{});
+
+    /**
+     * @brief Append {@link root_name} with {@link root} TAG_Compound to @p writer
+     * @param writer BufferWriter to append the NbtFile to
+     * @param endianness Endianness to write the NbtFile in
+     * @param compression The compression used for compressing the NbtFile (compression set by the constructor)
+     * @param options Deflate options (only used for gzip and zlib compression)
+     */
+    void write(BufferWriter &writer, nbtpp2::Endianness endianness, Compression compression = Compression::Detect,
+               const WriteOptions &options = WriteOptions{});
+
+    /**
+     * @brief Compute the exact size of the NbtFile written without compression
+     * @return Size of {@link root_name} with {@link root} in bytes
      */
-    void write(const std::string &path, nbtpp2::Endianness endianness, Compression compression = Compression::Detect);
+    std::size_t serialized_size() const;
+
+    /**
+     * @brief Write the NbtFile without compression into a buffer allocated once at its exact size
+     * @param endianness Endianness to write the NbtFile in
+     * @return The written NbtFile
+     */
+    std::vector<char> serialize(nbtpp2::Endianness endianness);
+
+    /**
+     * @brief Write the NbtFile without compression into a caller-provided buffer
+     * @param data Buffer to write to
+     * @param size Size of the buffer, at least serialized_size()
+     * @param endianness Endianness to write the NbtFile in
+     * @return Number of bytes written
+     * @throws std::runtime_error If the buffer is too small
+     */
+    std::size_t serialize(char *data, std::size_t size, nbtpp2::Endianness endianness);
 
     /**
      * @brief Get the root TAG_Compound contents of the NbtFile
      * @return Root TAG_Compound contents of the NbtFile
      * @throws std::runtime_error If the root tag is not a TagCompound
      */
-    std::map<std::string, Tag *> &get_root_tag_compound();
+    CompoundMap &get_root_tag_compound();
 
     /**
      * @brief Get the root Tag of the NbtFile
@@ -131,6 +248,13 @@ public:
      * @note Compression must not be Compression::Detect. The function will not set {@link write_compression} and return false.
      */
     bool set_write_compression(Compression compression);
+
+    /**
+     * @param threads Number of threads to deflate gzip output on (0 uses all hardware threads)
+     * @note With more than one thread, gzip output is deflated in independent blocks like pigz does, which
+     * makes the output slightly bigger
+     */
+    void set_write_threads(unsigned threads);
 };
 
 }
@@ -41,9 +41,13 @@ public:
     void write(BinaryWriter &writer, Endianness endianness) override
     {
         write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer, endianness);
-        for (auto &elem : value) {
-            writer.write(ConvertToChars<NumberT>{elem}.chars, sizeof(NumberT));
-        }
+        write_numbers<NumberT, NumberTUnsigned>(value.data(), value.size(), writer, endianness);
+    }
+
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override
+    {
+        return sizeof(std::int32_t) + value.size() * sizeof(NumberT);
     }
 
     /**
@@ -57,12 +61,9 @@ public:
     static auto read(BinaryReader &reader, Endianness endianness)
     {
         auto len = read_number<std::int32_t, std::uint32_t>(reader, endianness);
-        auto elems = ValT{};
-        elems.reserve(len);
-        for (std::int32_t i = 0; i < len; ++i) {
-            auto elem = read_number<NumberT, NumberTUnsigned>(reader, endianness);
-            elems.push_back(elem);
-        }
+        // The whole payload is read in one go and swapped in bulk
+        auto elems = ValT(static_cast<std::size_t>(len < 0 ? 0 : len));
+        read_numbers<NumberT, NumberTUnsigned>(reader, elems.data(), elems.size(), endianness);
         return new ResultT{std::move(elems)};
     }
 };
@@ -0,0 +1,106 @@
+#ifndef NBTPP2_NUMBER_LIST_TAG_HPP
+#define NBTPP2_NUMBER_LIST_TAG_HPP
+
+#include <nbtpp2/tag.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @brief TAG_List of numbers, stored contiguously instead of as separate tags
+ *
+ * Identifies as TagType::TagList and is written exactly like a TagList of @p ElementType tags. It is not a TagList;
+ * TagList::expand() converts it to one, which TagCompound::traverse() and TagList::traverse() do when a path continues
+ * into its elements.
+ * @tparam NumberT Number type
+ * @tparam NumberTUnsigned Unsigned number type (used for bitshifting)
+ * @tparam ElementType Tag type of the elements
+ */
+template<typename NumberT, typename NumberTUnsigned, TagType ElementType>
+class NumberListTag: public Tag
+{
+    static_assert(sizeof(NumberT) == sizeof(NumberTUnsigned), "NumberT and NumberTUnsigned must have the same size");
+
+    using ValT = std::vector<NumberT>;
+public:
+    ValT value;
+
+    /**
+     * @param value Value
+     */
+    explicit NumberListTag(ValT value)
+        : Tag{TagType::TagList}, value{std::move(value)}
+    {}
+
+    /**
+     * @brief Get the tag type of the elements
+     * @return The tag type of the elements
+     */
+    static TagType element_type()
+    {
+        return ElementType;
+    }
+
+    /**
+     * @brief Write NumberListTag
+     * @param writer BinaryWriter to write to
+     * @param endianness Endianness to write NumberListTag in
+     */
+    void write(BinaryWriter &writer, Endianness endianness) override
+    {
+        // Empty lists are written with TAG_End as element type, like TagList does
+        write_tag_id(value.empty() ? TagType::TagEnd : ElementType, writer);
+        write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer, endianness);
+        write_numbers<NumberT, NumberTUnsigned>(value.data(), value.size(), writer, endianness);
+    }
+
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override
+    {
+        return 1 + sizeof(std::int32_t) + value.size() * sizeof(NumberT);
+    }
+
+    /**
+     * @brief Read the elements of a NumberListTag (after its element type and length)
+     * @param reader BinaryReader to read from
+     * @param endianness Endianness to read the NumberListTag in
+     * @param len Number of elements
+     * @return Read NumberListTag
+     */
+    static NumberListTag *read_elements(BinaryReader &reader, Endianness endianness, std::int32_t len)
+    {
+        auto elems = ValT(static_cast<std::size_t>(len));
+        read_numbers<NumberT, NumberTUnsigned>(reader, elems.data(), elems.size(), endianness);
+        return new NumberListTag{std::move(elems)};
+    }
+};
+
+namespace tags
+{
+
+/// @brief TAG_List of TAG_Byte, stored contiguously
+using TagByteList = NumberListTag<std::int8_t, std::uint8_t, TagType::TagByte>;
+
+/// @brief TAG_List of TAG_Short, stored contiguously
+using TagShortList = NumberListTag<std::int16_t, std::uint16_t, TagType::TagShort>;
+
+/// @brief TAG_List of TAG_Int, stored contiguously
+using TagIntList = NumberListTag<std::int32_t, std::uint32_t, TagType::TagInt>;
+
+/// @brief TAG_List of TAG_Long, stored contiguously
+using TagLongList = NumberListTag<std::int64_t, std::uint64_t, TagType::TagLong>;
+
+/// @brief TAG_List of TAG_Float, stored contiguously
+using TagFloatList = NumberListTag<float, std::uint32_t, TagType::TagFloat>;
+
+/// @brief TAG_List of TAG_Double, stored contiguously
+using TagDoubleList = NumberListTag<double, std::uint64_t, TagType::TagDouble>;
+
+}
+
+}
+
+#endif //NBTPP2_NUMBER_LIST_TAG_HPP
@@ -34,6 +34,12 @@ public:
         write_number<NumberT, NumberTUnsigned>(value, writer, endianness);
     }
 
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override
+    {
+        return sizeof(NumberT);
+    }
+
     /**
      * @brief Read tag of type @p ResultT (extending NumberTag)
      * @tparam ResultT Result tag class type
@@ -0,0 +1,169 @@
+#ifndef NBTPP2_PATCH_HPP
+#define NBTPP2_PATCH_HPP
+
+#include <nbtpp2/endianness.hpp>
+#include <nbtpp2/io.hpp>
+#include <nbtpp2/tag_type.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace nbtpp2
+{
+
+/**
+ * @struct ValueLocation
+ * @brief Where the payload of a tag is in an encoded NBT file
+ */
+struct ValueLocation
+{
+    TagType type;
+    /// Offset of the payload from the start of the file
+    std::size_t offset;
+};
+
+namespace detail
+{
+
+template<typename T>
+struct PatchNumber;
+
+template<>
+struct PatchNumber<std::int8_t>
+{
+    static constexpr TagType type = TagType::TagByte;
+    using Unsigned = std::uint8_t;
+};
+
+template<>
+struct PatchNumber<std::int16_t>
+{
+    static constexpr TagType type = TagType::TagShort;
+    using Unsigned = std::uint16_t;
+};
+
+template<>
+struct PatchNumber<std::int32_t>
+{
+    static constexpr TagType type = TagType::TagInt;
+    using Unsigned = std::uint32_t;
+};
+
+template<>
+struct PatchNumber<std::int64_t>
+{
+    static constexpr TagType type = TagType::TagLong;
+    using Unsigned = std::uint64_t;
+};
+
+template<>
+struct PatchNumber<float>
+{
+    static constexpr TagType type = TagType::TagFloat;
+    using Unsigned = std::uint32_t;
+};
+
+template<>
+struct PatchNumber<double>
+{
+    static constexpr TagType type = TagType::TagDouble;
+    using Unsigned = std::uint64_t;
+};
+
+/**
+ * @brief Overwrite the payload of a tag in a buffer
+ * @param data Encoded NBT file
+ * @param size Size of the file
+ * @param endianness Endianness of the file
+ * @param path Path of the tag
+ * @param type Tag type the tag must have
+ * @param bytes New payload, with as many bytes as the old one
+ * @param count Number of bytes of the payload
+ */
+void patch_bytes(char *data, std::size_t size, Endianness endianness, const std::string &path, TagType type,
+                 const char *bytes, std::size_t count);
+
+/**
+ * @brief Overwrite the payload of a tag in an uncompressed file on disk
+ * @param file Path of the file
+ * @param endianness Endianness of the file
+ * @param path Path of the tag
+ * @param type Tag type the tag must have
+ * @param bytes New payload, with as many bytes as the old one
+ * @param count Number of bytes of the payload
+ */
+void patch_file_bytes(const std::string &file, Endianness endianness, const std::string &path, TagType type,
+                      const char *bytes, std::size_t count);
+
+}
+
+/**
+ * @brief Find the payload of a tag in an encoded NBT file, skipping everything before it without parsing it
+ *
+ * A path names compound entries separated by dots, relative to the root tag, like `Data.Time`. `[index]` after a
+ * name selects an element of a list, like `Pos[1]` or `Inventory[0].Count`.
+ * @param reader BinaryReader positioned at the start of the file (offsets are counted from there)
+ * @param endianness Endianness of the file
+ * @param path Path of the tag
+ * @return The type and offset of the payload of the tag
+ * @throws std::runtime_error If the path is malformed, there is no tag at the path or the file is malformed
+ */
+ValueLocation locate_value(BinaryReader &reader, Endianness endianness, const std::string &path);
+
+/**
+ * @brief Find the payload of a tag in an encoded NBT file in memory (uncompressed, like the buffer of an MmapReader)
+ * @param data Encoded NBT file
+ * @param size Size of the file
+ * @copydetails locate_value(BinaryReader &, Endianness, const std::string &)
+ */
+ValueLocation locate_value(const char *data, std::size_t size, Endianness endianness, const std::string &path);
+
+/**
+ * @brief Overwrite a number tag in an encoded NBT file in memory, without parsing or writing the rest of the file
+ *
+ * @code
+ * nbtpp2::patch_value(buffer.data(), buffer.size(), nbtpp2::Endianness::Big, "Data.Time", std::int64_t{24000});
+ * @endcode
+ * @tparam NumberT Type of the number: std::int8_t, std::int16_t, std::int32_t, std::int64_t, float or double for a
+ * TAG_Byte, TAG_Short, TAG_Int, TAG_Long, TAG_Float or TAG_Double
+ * @param data Uncompressed NBT file
+ * @param size Size of the file
+ * @param endianness Endianness of the file
+ * @param path Path of the tag, see locate_value()
+ * @param value New value of the tag
+ * @throws std::runtime_error If there is no tag at the path or it is not of the tag type of @p NumberT
+ */
+template<typename NumberT>
+void patch_value(char *data, std::size_t size, Endianness endianness, const std::string &path, NumberT value)
+{
+    using Number = detail::PatchNumber<NumberT>;
+    char bytes[sizeof(NumberT)];
+    SpanWriter writer{bytes, sizeof(bytes)};
+    write_number<NumberT, typename Number::Unsigned>(value, writer, endianness);
+    detail::patch_bytes(data, size, endianness, path, Number::type, bytes, sizeof(bytes));
+}
+
+/**
+ * @brief Overwrite a number tag in an uncompressed NBT file on disk, only writing the bytes of the number
+ * @param file Path of the file
+ * @param endianness Endianness of the file
+ * @param path Path of the tag, see locate_value()
+ * @param value New value of the tag
+ * @throws std::runtime_error If the file cannot be opened or is compressed, there is no tag at the path or it is not of
+ * the tag type of @p NumberT
+ * @see patch_value()
+ */
+template<typename NumberT>
+void patch_file(const std::string &file, Endianness endianness, const std::string &path, NumberT value)
+{
+    using Number = detail::PatchNumber<NumberT>;
+    char bytes[sizeof(NumberT)];
+    SpanWriter writer{bytes, sizeof(bytes)};
+    write_number<NumberT, typename Number::Unsigned>(value, writer, endianness);
+    detail::patch_file_bytes(file, endianness, path, Number::type, bytes, sizeof(bytes));
+}
+
+}
+
+#endif //NBTPP2_PATCH_HPP
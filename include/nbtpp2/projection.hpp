@@ -0,0 +1,79 @@
+#ifndef NBTPP2_PROJECTION_HPP
+#define NBTPP2_PROJECTION_HPP
+
+#include <nbtpp2/key.hpp>
+
+#include <string>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @class Projection
+ * @brief Tree of the paths selected with ReadOptions::paths, matched against the tags while they are read
+ *
+ * A path names compound entries separated by dots, relative to the root tag, like `Level.xPos`. `[*]` after a name
+ * selects every element of a list, like `Level.Entities[*].id`; it may be left out, as a path continuing into a list
+ * is applied to each of its elements. A path ending at a tag selects that tag with everything inside it.
+ */
+class Projection
+{
+    /// Name of the compound entry this node matches (empty for the root node and for list elements)
+    Key name;
+
+    /// Whether this node matches the elements of a list (`[*]`) instead of a compound entry
+    bool elements = false;
+
+    /// Whether a path ends at this node, selecting everything inside it
+    bool whole = false;
+
+    std::vector<Projection> children;
+
+    /**
+     * @brief Get a child node, adding it if it does not exist yet
+     * @param name Name of the compound entry the child matches
+     * @param elements Whether the child matches the elements of a list
+     * @return The child node
+     */
+    Projection &child(const Key &name, bool elements);
+
+public:
+    Projection() = default;
+
+    /**
+     * @param paths Paths to select
+     * @throws std::runtime_error If a path is malformed
+     */
+    explicit Projection(const std::vector<std::string> &paths);
+
+    /**
+     * @brief Select another path
+     * @param path Path to select
+     * @throws std::runtime_error If the path is malformed
+     */
+    void add(const std::string &path);
+
+    /**
+     * @brief Check whether everything inside the tag matched by this node is selected
+     * @return Whether a path ends at this node
+     */
+    bool selects_all() const;
+
+    /**
+     * @brief Find the node matching an entry of the compound matched by this node
+     * @param name Name of the entry
+     * @return The node for the entry, or nullptr if the entry is not selected
+     */
+    const Projection *field(const Key &name) const;
+
+    /**
+     * @brief Get the node matching the elements of the list matched by this node
+     * @return The `[*]` node, or this node if the paths do not name the elements explicitly
+     */
+    const Projection *element() const;
+};
+
+}
+
+#endif //NBTPP2_PROJECTION_HPP
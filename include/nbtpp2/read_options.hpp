@@ -0,0 +1,47 @@
+#ifndef NBTPP2_READ_OPTIONS_HPP
+#define NBTPP2_READ_OPTIONS_HPP
+
+#include <string>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @struct ReadOptions
+ * @brief Options for reading NBT files
+ */
+struct ReadOptions
+{
+    /// Map the whole (compressed) file and inflate it into one buffer up front instead of inflating per read
+    bool in_memory = false;
+
+    /**
+     * Allocate the tags of the file from an Arena owned by the NbtFile, which frees them all at once.
+     * Tags read this way must not be moved to a tree that outlives the NbtFile (and its copies).
+     */
+    bool arena = false;
+
+    /**
+     * Read lists of numbers (TAG_Byte up to TAG_Double) as a NumberListTag storing the numbers contiguously,
+     * instead of as a TagList of separate tags
+     */
+    bool typed_lists = false;
+
+    /**
+     * Only skip over compounds, lists and arrays inside compounds while reading, and parse them when they are first
+     * accessed through their CompoundMap (see LazyTag). Keeps the whole decompressed file in memory.
+     * Lazily read trees must not be accessed from multiple threads at once, even for reading.
+     */
+    bool lazy = false;
+
+    /**
+     * Only build the tags on these paths (see Projection for their syntax), skipping everything else without parsing
+     * it. Empty reads the whole file.
+     */
+    std::vector<std::string> paths;
+};
+
+}
+
+#endif //NBTPP2_READ_OPTIONS_HPP
@@ -0,0 +1,289 @@
+#ifndef NBTPP2_REGION_FILE_HPP
+#define NBTPP2_REGION_FILE_HPP
+
+#include <nbtpp2/nbt_file.hpp>
+#include <nbtpp2/io.hpp>
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/// Size of a region file sector in bytes
+const std::size_t REGION_SECTOR_SIZE = 4096;
+
+/// Number of chunks in a region file (32 by 32)
+const std::size_t REGION_CHUNKS = 1024;
+
+/**
+ * @class RegionFile
+ * @brief Random-access reader for Anvil (.mca) and McRegion (.mcr) region files
+ *
+ * The region file is memory-mapped, so reading a chunk only touches the sectors of that chunk.
+ * Chunk coordinates can be given either relative to the region (0-31) or as absolute chunk coordinates.
+ */
+class RegionFile
+{
+public:
+    /**
+     * @enum ChunkCompression
+     * @brief Compression scheme of a chunk, as stored in its chunk header
+     */
+    enum class ChunkCompression: std::uint8_t
+    {
+        Gzip = 1, ///< gzip (unused by Minecraft itself)
+        Zlib = 2, ///< zlib (the default)
+        None = 3, ///< Uncompressed
+        Lz4 = 4, ///< LZ4 block stream as written by lz4-java (not supported)
+        Custom = 127, ///< Custom compression named in the chunk (not supported)
+    };
+
+private:
+    /// Path of the region file, used for finding external (.mcc) chunks
+    std::string path;
+
+    /// The mapped region file
+    MmapReader file;
+
+    /// Location entries: sector offset in the upper 24 bits, sector count in the lower 8 bits
+    std::uint32_t locations[REGION_CHUNKS] = {0};
+
+    /// Last modification times (seconds since the epoch)
+    std::uint32_t timestamps[REGION_CHUNKS] = {0};
+
+    /**
+     * @brief Get the index of a chunk in the location and timestamp tables
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @return Index of the chunk
+     */
+    static std::size_t index(int x, int z);
+
+    /**
+     * @brief Read a chunk stored in an external c.x.z.mcc file
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @param compression Compression of the external file
+     * @param options Options for reading the chunk
+     * @return The chunk
+     * @throws std::runtime_error If the region coordinates cannot be derived from the file name
+     */
+    NbtFile read_external_chunk(int x, int z, ChunkCompression compression, const ReadOptions &options) const;
+
+public:
+    /**
+     * @brief Open a region file and read its location and timestamp tables
+     * @param path Path of the region file
+     * @throws std::runtime_error If the file cannot be opened or is not a region file
+     */
+    explicit RegionFile(const std::string &path);
+
+    /**
+     * @brief Get the path of the region file
+     * @return Path of the region file
+     */
+    const std::string &get_path() const;
+
+    /**
+     * @brief Check whether a chunk is present
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @return Whether the chunk is present
+     */
+    bool has_chunk(int x, int z) const;
+
+    /**
+     * @brief Get the last modification time of a chunk
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @return Modification time in seconds since the epoch (0 if the chunk is not present)
+     */
+    std::uint32_t timestamp(int x, int z) const;
+
+    /**
+     * @brief Read and decompress a chunk
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @param options Options for reading the chunk's NBT data
+     * @return The chunk's NBT data
+     * @throws std::runtime_error If the chunk is not present, is corrupt or uses an unsupported compression
+     */
+    NbtFile read_chunk(int x, int z, const ReadOptions &options = ReadOptions{}) const;
+};
+
+/**
+ * @class RegionWriter
+ * @brief Updates single chunks of an Anvil (.mca) region file in place
+ *
+ * Freed sectors are kept in a free list and reused (first fit) before the file is grown. A chunk is always written to
+ * newly allocated sectors before its location entry is updated, so a crash never leaves a chunk half-written.
+ * Chunks of more than 255 sectors are stored in an external c.x.z.mcc file next to the region file, which is written
+ * to a temporary file and renamed into place, and only deleted after the location entry no longer refers to it.
+ * @note A RegionFile opened on the same file does not see changes made after it was opened
+ */
+class RegionWriter
+{
+    /// Path of the region file
+    std::string path;
+
+    /// The open region file
+    FILE *file = nullptr;
+
+    /// Location entries: sector offset in the upper 24 bits, sector count in the lower 8 bits
+    std::uint32_t locations[REGION_CHUNKS] = {0};
+
+    /// Last modification times (seconds since the epoch)
+    std::uint32_t timestamps[REGION_CHUNKS] = {0};
+
+    /// Free runs of sectors before the end of the file: first sector to number of sectors
+    std::map<std::uint32_t, std::uint32_t> free_sectors;
+
+    /// Number of sectors in the file
+    std::uint32_t file_sectors = 0;
+
+    /// @brief Open {@link path} and read the tables, or create it with empty tables
+    void open();
+
+    /**
+     * @brief Allocate a run of sectors, reusing free sectors if possible
+     * @param count Number of sectors to allocate
+     * @return First allocated sector
+     * @throws std::runtime_error If no run can be found at a sector a location entry can address
+     */
+    std::uint32_t allocate(std::uint32_t count);
+
+    /**
+     * @brief Return a run of sectors to the free list
+     * @param first First sector of the run
+     * @param count Number of sectors in the run
+     */
+    void release(std::uint32_t first, std::uint32_t count);
+
+    /**
+     * @brief Write data to the file at an offset
+     * @param offset Offset in bytes
+     * @param data Data to write
+     * @param size Size of @p data
+     */
+    void write_at(std::size_t offset, const char *data, std::size_t size);
+
+    /**
+     * @brief Write the location and timestamp entry of a chunk to the file
+     * @param index Index of the chunk
+     */
+    void write_entry(std::size_t index);
+
+    /**
+     * @brief Store a compressed chunk
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @param data Compressed chunk data
+     * @param size Size of @p data
+     * @param compression Compression of @p data
+     * @param timestamp Modification time to store
+     */
+    void write_payload(int x, int z, const char *data, std::size_t size, RegionFile::ChunkCompression compression,
+                       std::uint32_t timestamp);
+
+public:
+    /**
+     * @brief Open a region file for writing, creating it if it does not exist
+     * @param path Path of the region file
+     * @throws std::runtime_error If the file cannot be opened or is not a region file
+     */
+    explicit RegionWriter(const std::string &path);
+
+    RegionWriter(const RegionWriter &) = delete;
+
+    RegionWriter &operator=(const RegionWriter &) = delete;
+
+    ~RegionWriter();
+
+    /**
+     * @brief Write a chunk, replacing the chunk that was there
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     * @param chunk Chunk to write
+     * @param compression Compression to store the chunk with (gzip, zlib or none)
+     * @param options Deflate options
+     */
+    void write_chunk(int x, int z, NbtFile &chunk, RegionFile::ChunkCompression compression = RegionFile::ChunkCompression::Zlib,
+                     const WriteOptions &options = WriteOptions{});
+
+    /**
+     * @brief Remove a chunk, freeing its sectors and deleting its external file
+     * @param x Chunk x coordinate
+     * @param z Chunk z coordinate
+     */
+    void remove_chunk(int x, int z);
+
+    /**
+     * @brief Get the number of sectors that are free for reuse
+     * @return Number of free sectors
+     */
+    std::uint32_t free_sector_count() const;
+
+    /**
+     * @brief Get the size of the region file in sectors
+     * @return Size of the region file in sectors
+     */
+    std::uint32_t sector_count() const;
+
+    /**
+     * @brief Rewrite the region file with all chunks packed back to back, dropping all free sectors
+     * @note The region file is rewritten to a temporary file which is flushed to disk and then atomically renamed over
+     * the original, so a crash leaves either the old or the compacted region file
+     */
+    void compact();
+};
+
+/**
+ * @brief Callback receiving a decoded chunk
+ *
+ * Takes the path of the region file the chunk came from, the chunk coordinates within the region (0-31) and the chunk.
+ */
+using ChunkCallback = std::function<void(const std::string &region_path, int x, int z, NbtFile &chunk)>;
+
+/**
+ * @brief Decode every chunk of a set of region files in parallel
+ *
+ * Regions and their chunks are decoded as independent jobs on a work-stealing ThreadPool, so a few large regions
+ * are spread over all workers as well.
+ * @param paths Paths of the region files
+ * @param callback Called for every chunk, concurrently from the worker threads
+ * @param threads Number of worker threads (0 uses the number of hardware threads)
+ * @param options Options for reading the chunks (ReadOptions::paths keeps decoding down to the fields a query needs)
+ * @throws std::runtime_error (or whatever @p callback throws) The first error hit by a job, after the remaining jobs
+ * have finished; no new chunks are decoded after an error
+ */
+void decode_regions(const std::vector<std::string> &paths, const ChunkCallback &callback, unsigned threads = 0,
+                    const ReadOptions &options = ReadOptions{});
+
+/**
+ * @brief Find the region files of a world
+ *
+ * Looks in the region directories of the overworld, the Nether (DIM-1) and the End (DIM1).
+ * @param world_path Path of the world directory
+ * @return Paths of the .mca files found, sorted
+ */
+std::vector<std::string> find_region_files(const std::string &world_path);
+
+/**
+ * @brief Decode every chunk of a world in parallel
+ * @param world_path Path of the world directory
+ * @param callback Called for every chunk, concurrently from the worker threads
+ * @param threads Number of worker threads (0 uses the number of hardware threads)
+ * @param options Options for reading the chunks
+ * @see decode_regions
+ */
+void decode_world(const std::string &world_path, const ChunkCallback &callback, unsigned threads = 0,
+                  const ReadOptions &options = ReadOptions{});
+
+}
+
+#endif //NBTPP2_REGION_FILE_HPP
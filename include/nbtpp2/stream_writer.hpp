@@ -0,0 +1,173 @@
+#ifndef NBTPP2_STREAM_WRITER_HPP
+#define NBTPP2_STREAM_WRITER_HPP
+
+#include <nbtpp2/endianness.hpp>
+#include <nbtpp2/io.hpp>
+#include <nbtpp2/tag.hpp>
+#include <nbtpp2/tag_type.hpp>
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @class NbtStreamWriter
+ * @brief Writes an NBT file tag by tag straight into a BinaryWriter, without building a tree
+ *
+ * The first tag written is the root tag. Inside a compound every tag needs a name, elements of a list are written
+ * with an empty name (any other name is ignored) and must have the list's element type.
+ * Lists are written with their length up front; when writing to a BufferWriter the length can also be left out and is
+ * filled in by end_list().
+ *
+ * @code
+ * NbtStreamWriter stream{writer, Endianness::Big};
+ * stream.begin_compound("");
+ * stream.write_int("DataVersion", 3465);
+ * stream.write_long_array("BlockStates", states.data(), states.size());
+ * stream.end_compound();
+ * @endcode
+ */
+class NbtStreamWriter
+{
+    /// Compound or list being written
+    struct Frame
+    {
+        TagType container;
+        TagType element_type;
+        /// Declared length of a list, or -1 if it is filled in by end_list()
+        std::int32_t length;
+        std::int32_t written;
+        /// Offset of the length of a list in {@link buffer}, if it is filled in by end_list()
+        std::size_t length_offset;
+    };
+
+    BinaryWriter &writer;
+    /// @p writer as BufferWriter (if it is one), for filling in list lengths afterwards
+    BufferWriter *buffer;
+    Endianness endianness;
+    std::vector<Frame> frames;
+    bool root_written = false;
+
+    /**
+     * @brief Write the id and name of a tag, or check the element type if in a list
+     * @param type Tag type of the tag
+     * @param name Name of the tag
+     * @throws std::runtime_error If the tag does not fit where it is written
+     */
+    void begin_tag(TagType type, const std::string &name);
+
+    /**
+     * @brief Start a compound or list after its id and name have been written
+     * @param frame Compound or list
+     */
+    void push(const Frame &frame);
+
+    /**
+     * @brief Finish the current compound or list
+     * @param container Expected container type
+     * @return The finished compound or list
+     * @throws std::runtime_error If the current container is not a @p container
+     */
+    Frame pop(TagType container);
+
+public:
+    /**
+     * @param writer BinaryWriter to write to
+     * @param endianness Endianness to write in
+     */
+    NbtStreamWriter(BinaryWriter &writer, Endianness endianness);
+
+    /**
+     * @brief Start a TAG_Compound, whose entries are written until end_compound()
+     * @param name Name of the compound
+     */
+    void begin_compound(const std::string &name);
+
+    /**
+     * @brief Finish the current TAG_Compound
+     * @throws std::runtime_error If no compound is being written
+     */
+    void end_compound();
+
+    /**
+     * @brief Start a TAG_List of a known length, whose elements are written until end_list()
+     * @param name Name of the list
+     * @param element_type Tag type of the elements
+     * @param length Number of elements
+     */
+    void begin_list(const std::string &name, TagType element_type, std::int32_t length);
+
+    /**
+     * @brief Start a TAG_List whose length is filled in by end_list()
+     * @param name Name of the list
+     * @param element_type Tag type of the elements
+     * @throws std::runtime_error If the writer is not a BufferWriter
+     */
+    void begin_list(const std::string &name, TagType element_type);
+
+    /**
+     * @brief Finish the current TAG_List
+     * @throws std::runtime_error If no list is being written, or a different number of elements than declared was
+     * written
+     */
+    void end_list();
+
+    /**
+     * @brief Write a TAG_Byte
+     * @param name Name of the tag
+     * @param value Value of the tag
+     */
+    void write_byte(const std::string &name, std::int8_t value);
+
+    /// @brief Write a TAG_Short @copydetails write_byte
+    void write_short(const std::string &name, std::int16_t value);
+
+    /// @brief Write a TAG_Int @copydetails write_byte
+    void write_int(const std::string &name, std::int32_t value);
+
+    /// @brief Write a TAG_Long @copydetails write_byte
+    void write_long(const std::string &name, std::int64_t value);
+
+    /// @brief Write a TAG_Float @copydetails write_byte
+    void write_float(const std::string &name, float value);
+
+    /// @brief Write a TAG_Double @copydetails write_byte
+    void write_double(const std::string &name, double value);
+
+    /// @brief Write a TAG_String @copydetails write_byte
+    void write_string(const std::string &name, const std::string &value);
+
+    /**
+     * @brief Write a TAG_Byte_Array
+     * @param name Name of the tag
+     * @param data Elements of the array
+     * @param size Number of elements
+     */
+    void write_byte_array(const std::string &name, const std::int8_t *data, std::size_t size);
+
+    /// @brief Write a TAG_Int_Array @copydetails write_byte_array
+    void write_int_array(const std::string &name, const std::int32_t *data, std::size_t size);
+
+    /// @brief Write a TAG_Long_Array @copydetails write_byte_array
+    void write_long_array(const std::string &name, const std::int64_t *data, std::size_t size);
+
+    /**
+     * @brief Write an existing tag
+     * @param name Name of the tag
+     * @param tag Tag to write
+     */
+    void write_tag(const std::string &name, Tag &tag);
+
+    /**
+     * @brief Get the number of compounds and lists being written
+     * @return The depth of the writer (0 before the root tag and after it has been finished)
+     */
+    std::size_t depth() const;
+};
+
+}
+
+#endif //NBTPP2_STREAM_WRITER_HPP
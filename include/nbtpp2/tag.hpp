@@ -5,6 +5,7 @@
 #include <nbtpp2/tag_type.hpp>
 #include <nbtpp2/endianness.hpp>
 
+#include <cstddef>
 #include <stdexcept>
 
 namespace nbtpp2
@@ -22,6 +23,16 @@ namespace tags
 class Tag
 {
     const TagType type;
+    const bool lazy = false;
+
+protected:
+    /**
+     * @brief Tag constructor for tags standing in for a tag that has not been parsed yet
+     * @param type The tag type as TagType (used for identify())
+     * @param lazy Whether the tag is a LazyTag
+     */
+    Tag(TagType type, bool lazy);
+
 public:
     /**
      * @brief Tag constructor
@@ -34,6 +45,19 @@ public:
      */
     virtual ~Tag() = default;
 
+    /**
+     * @brief Allocate a tag, from the thread's active Arena if there is one
+     * @param size Size of the tag
+     * @return Pointer to the memory for the tag
+     */
+    static void *operator new(std::size_t size);
+
+    /**
+     * @brief Free a tag (a no-op for tags in an Arena, which are freed with the arena)
+     * @param ptr Pointer to the tag
+     */
+    static void operator delete(void *ptr);
+
     /**
      * @brief Write tag to ostream with desired endianness
      * @param writer BinaryWriter to write the tag to
@@ -41,11 +65,26 @@ public:
      */
     virtual void write(BinaryWriter &writer, Endianness endianness) = 0;
 
+    /**
+     * @brief Compute the exact number of bytes write() produces for the tag (its payload, without id and name)
+     *
+     * The size does not depend on the endianness. Tags that do not override this are written to a CountingWriter.
+     * @return Size of the encoded tag in bytes
+     */
+    virtual std::size_t serialized_size() const;
+
     /**
      * @brief Get the internal tag type of the tag
      * @return The internal tag type of the tag
      */
-    TagType identify();
+    TagType identify() const;
+
+    /**
+     * @brief Check whether the tag is a LazyTag, the unparsed form of a tag
+     * @return Whether the tag is a LazyTag
+     */
+    bool is_lazy() const
+    { return lazy; }
 
     /**
      * @brief Shorthand for casting tag to desired tag type
@@ -58,6 +97,9 @@ public:
     {
         auto result = dynamic_cast<TagT *>(this);
         if (result == nullptr) {
+            if (type == TagType::TagList)
+                throw std::runtime_error("error casting tag to desired type (lists read with ReadOptions::typed_lists "
+                                         "may be NumberListTags, see TagList::expand())");
             throw std::runtime_error("error casting tag to desired type");
         }
         return *result;
@@ -2,20 +2,32 @@
 #define NBTPP2_TAG_COMPOUND_HPP
 
 #include <nbtpp2/tag.hpp>
+#include <nbtpp2/read_options.hpp>
+#include <nbtpp2/compound_map.hpp>
 
-#include <map>
 #include <vector>
 
 namespace nbtpp2
 {
 
+class Projection;
+
 namespace tags
 {
 
 /// @brief TAG_Compound
 class TagCompound: public Tag
 {
-    using ValT = std::map<std::string, Tag *>;
+    using ValT = CompoundMap;
+
+    /**
+     * @brief Write the entries of the TAG_Compound, in an endianness known at compile time
+     * @tparam E Endianness to write the entries in
+     * @param writer BinaryWriter to write to
+     */
+    template<Endianness E>
+    void write_entries(BinaryWriter &writer);
+
 public:
     ValT value;
 
@@ -28,21 +40,34 @@ public:
      */
     void write(BinaryWriter &writer, Endianness endianness) override;
 
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override;
+
     /**
      * @brief Read a TAG_Compound
      * @param reader BinaryReader to read from
      * @param endianness Endianness to read the TAG_Compound's contents in
+     * @param options Options for reading the tags in the TAG_Compound
+     * @param projection Entries to build, the others are skipped (nullptr builds all of them)
+     * @return Read TagCompound
+     */
+    static TagCompound *read(BinaryReader &reader, Endianness endianness, const ReadOptions &options = ReadOptions{},
+                             const Projection *projection = nullptr);
+
+    /**
+     * @brief Read a TAG_Compound, in an endianness known at compile time
+     * @tparam E Endianness to read the TAG_Compound's contents in
+     * @param reader BinaryReader to read from
+     * @param options Options for reading the tags in the TAG_Compound
+     * @param projection Entries to build, the others are skipped (nullptr builds all of them)
      * @return Read TagCompound
      */
-    static TagCompound *read(BinaryReader &reader, Endianness endianness);
+    template<Endianness E>
+    static TagCompound *read(BinaryReader &reader, const ReadOptions &options = ReadOptions{},
+                             const Projection *projection = nullptr);
 
     /// @brief Custom destructor for deleting Tags in {@link value}
-    ~TagCompound() override
-    {
-        for (auto &it : value) {
-            delete it.second;
-        }
-    }
+    ~TagCompound() override;
 
     /**
      * @brief Traverse TagCompound to find tag quickly
@@ -2,12 +2,15 @@
 #define NBTPP2_TAG_LIST_HPP
 
 #include <nbtpp2/tag.hpp>
+#include <nbtpp2/read_options.hpp>
 
 #include <vector>
 
 namespace nbtpp2
 {
 
+class Projection;
+
 namespace tags
 {
 
@@ -15,6 +18,15 @@ namespace tags
 class TagList: public Tag
 {
     using ValT = std::vector<Tag *>;
+
+    /**
+     * @brief Write the element type, length and elements of the TAG_List, in an endianness known at compile time
+     * @tparam E Endianness to write the TAG_List in
+     * @param writer BinaryWriter to write to
+     */
+    template<Endianness E>
+    void write_elements(BinaryWriter &writer);
+
 public:
     ValT value;
 
@@ -27,16 +39,57 @@ public:
      */
     void write(BinaryWriter &writer, Endianness endianness) override;
 
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override;
+
     /**
      * @brief Read a TAG_List
      * @param reader BinaryReader to read from
      * @param endianness Endianness to read the TAG_List in
+     * @param options Options for reading the tags in the TAG_List
      * @return Read TAG_List
      */
-    static TagList *read(BinaryReader &reader, Endianness endianness);
+    static TagList *read(BinaryReader &reader, Endianness endianness, const ReadOptions &options = ReadOptions{});
+
+    /**
+     * @brief Read the elements of a TAG_List (after its element type and length)
+     * @param reader BinaryReader to read from
+     * @param endianness Endianness to read the TAG_List in
+     * @param tag_type Tag type of the elements
+     * @param len Number of elements
+     * @param options Options for reading the tags in the TAG_List
+     * @param projection Part of the TAG_List to build, applied to each element (nullptr builds all of it)
+     * @return Read TAG_List
+     */
+    static TagList *read_elements(BinaryReader &reader, Endianness endianness, TagType tag_type, std::int32_t len,
+                                  const ReadOptions &options = ReadOptions{}, const Projection *projection = nullptr);
+
+    /**
+     * @brief Read the elements of a TAG_List, in an endianness known at compile time
+     * @tparam E Endianness to read the TAG_List in
+     * @param reader BinaryReader to read from
+     * @param tag_type Tag type of the elements
+     * @param len Number of elements
+     * @param options Options for reading the tags in the TAG_List
+     * @param projection Part of the TAG_List to build, applied to each element (nullptr builds all of it)
+     * @return Read TAG_List
+     */
+    template<Endianness E>
+    static TagList *read_elements(BinaryReader &reader, TagType tag_type, std::int32_t len,
+                                  const ReadOptions &options = ReadOptions{}, const Projection *projection = nullptr);
 
     Tag *traverse(std::vector<std::string> path_parts);
 
+    /**
+     * @brief Get a list as TagList, replacing a typed list (a NumberListTag, see ReadOptions::typed_lists) by an
+     * equivalent TagList of separate tags first
+     * @param tag Reference to the pointer to the list, updated if the list is replaced
+     * @return The list as TagList
+     * @throws std::runtime_error If @p tag is not a list
+     * @note Replacing a typed list deletes it, invalidating references to it
+     */
+    static TagList &expand(Tag *&tag);
+
     /// @brief Custom destructor to delete tags in {@link value}
     ~TagList() override
     {
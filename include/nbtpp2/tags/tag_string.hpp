@@ -25,6 +25,9 @@ public:
      */
     void write(BinaryWriter &writer, Endianness endianness) override;
 
+    /// @copydoc Tag::serialized_size
+    std::size_t serialized_size() const override;
+
     /**
      * @brief Read a TAG_String
      * @param reader BinaryReader to read from
@@ -0,0 +1,105 @@
+#ifndef NBTPP2_THREAD_POOL_HPP
+#define NBTPP2_THREAD_POOL_HPP
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace nbtpp2
+{
+
+/**
+ * @class ThreadPool
+ * @brief Fixed-size pool of worker threads running submitted jobs, balanced by work stealing
+ *
+ * Every worker has its own job queue. Jobs submitted from a worker go to the back of that worker's queue and are
+ * picked up from the back again (so nested jobs run depth first and stay cache-warm), jobs submitted from other
+ * threads are spread over the queues round robin. A worker whose queue is empty steals from the front of the others.
+ */
+class ThreadPool
+{
+    /// Job queue of a single worker
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<std::function<void()>> jobs;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;
+    std::vector<std::thread> workers;
+
+    /// Protects {@link queued} and {@link stopping}
+    std::mutex mutex;
+    std::condition_variable cv;
+
+    /// Number of jobs in the queues not yet claimed by a worker
+    std::size_t queued = 0;
+
+    /// Queue the next job from outside the pool goes to
+    std::atomic<std::size_t> next_queue{0};
+
+    bool stopping = false;
+
+    /**
+     * @brief Worker thread loop
+     * @param index Index of the worker's own queue
+     */
+    void work(std::size_t index);
+
+    /**
+     * @brief Take a job, from the back of the worker's own queue or else from the front of another queue
+     * @param index Index of the worker's own queue
+     * @return The job
+     */
+    std::function<void()> take(std::size_t index);
+
+    /**
+     * @brief Queue a job for the workers
+     * @param job Job to run
+     */
+    void push(std::function<void()> job);
+
+public:
+    /**
+     * @param threads Number of worker threads (0 uses the number of hardware threads)
+     */
+    explicit ThreadPool(unsigned threads = 0);
+
+    ThreadPool(const ThreadPool &) = delete;
+
+    ThreadPool &operator=(const ThreadPool &) = delete;
+
+    /// @brief Waits for all queued jobs to finish and joins the workers
+    ~ThreadPool();
+
+    /**
+     * @brief Get the number of worker threads
+     * @return The number of worker threads
+     */
+    unsigned size() const;
+
+    /**
+     * @brief Run @p f on one of the workers
+     * @tparam F Callable type
+     * @param f Callable to run
+     * @return Future for the result of @p f (exceptions thrown by @p f are rethrown by its get())
+     */
+    template<typename F>
+    auto submit(F f) -> std::future<decltype(f())>
+    {
+        auto task = std::make_shared<std::packaged_task<decltype(f())()>>(std::move(f));
+        auto result = task->get_future();
+        push([task]() { (*task)(); });
+        return result;
+    }
+};
+
+}
+
+#endif //NBTPP2_THREAD_POOL_HPP
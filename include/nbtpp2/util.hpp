@@ -1,20 +1,30 @@
 #ifndef NBTPP2_UTIL_HPP
 #define NBTPP2_UTIL_HPP
 
+#include <nbtpp2/byte_swap.hpp>
 #include <nbtpp2/converters.hpp>
 #include <nbtpp2/endianness.hpp>
 #include <nbtpp2/tag_type.hpp>
 #include <nbtpp2/tag.hpp>
 #include <nbtpp2/io.hpp>
+#include <nbtpp2/key.hpp>
+#include <nbtpp2/read_options.hpp>
 
 #include <cstdint>
+#include <cstring>
 #include <ostream>
 #include <istream>
 #include <string>
+#include <type_traits>
 
 namespace nbtpp2
 {
 
+class Projection;
+
+/// Deepest nesting of compounds and lists skip_tag() can skip (the limit Minecraft itself enforces)
+const std::size_t MAX_SKIP_DEPTH = 512;
+
 /**
  * @brief Reverse an unsigned integer
  * @tparam UintT Type of the unsigned integer
@@ -24,11 +34,11 @@ namespace nbtpp2
 template<typename UintT>
 auto reverse_uint(UintT value)
 {
-    UintT result = 0;
-    for (std::size_t i = 0; i < sizeof(value); ++i) {
-        result |= ((value >> (i * 8)) & 0xFF) << ((sizeof(value) - i) * 8 - 8);
-    }
-    return result;
+    using FixedT = std::conditional_t<sizeof(UintT) == 1, std::uint8_t,
+                   std::conditional_t<sizeof(UintT) == 2, std::uint16_t,
+                   std::conditional_t<sizeof(UintT) == 4, std::uint32_t, std::uint64_t>>>;
+    static_assert(sizeof(FixedT) == sizeof(UintT), "UintT must be 1, 2, 4 or 8 bytes");
+    return static_cast<UintT>(byte_swap(static_cast<FixedT>(value)));
 }
 
 /**
@@ -45,31 +55,134 @@ auto optional_reverse_uint(UintT value, Endianness target_endianness)
 }
 
 /**
- * @brief Write a number to a BinaryWriter
+ * @brief Reverse an unsigned integer if the system endianness does not equal the target endianness, with the target
+ * endianness known at compile time
+ * @tparam TargetEndianness Target endianness
+ * @tparam UintT Type of the unsigned integer
+ * @param value Value of the unsigned integer
+ * @return Reversed unsigned integer
+ */
+template<Endianness TargetEndianness, typename UintT>
+auto optional_reverse_uint(UintT value)
+{
+    return TargetEndianness != SYSTEM_ENDIANNESS ? reverse_uint(value) : value;
+}
+
+/**
+ * @brief Write a number to a BinaryWriter, in an endianness known at compile time
+ * @tparam E Endianness to write the number in
  * @tparam NumberT (signed) input number type
  * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
  * @param value Value of the number in NumberT
- * @param out BinaryWriter to write to
- * @param endianness Endianness to write the number in
+ * @param writer BinaryWriter to write to
  */
-template<typename NumberT, typename NumberTUnsigned>
-void write_number(NumberT value, BinaryWriter &writer, Endianness endianness)
+template<Endianness E, typename NumberT, typename NumberTUnsigned>
+void write_number(NumberT value, BinaryWriter &writer)
 {
     static_assert(sizeof(NumberT) == sizeof(NumberTUnsigned), "NumberT and NumberTUnsigned must have the same size");
 
     writer.write(
         ConvertToChars<NumberTUnsigned>{
-            optional_reverse_uint(
+            optional_reverse_uint<E>(
                 Convert<NumberT, NumberTUnsigned>{
                     value
-                }.b,
-                endianness
+                }.b
             )
         }.chars,
         sizeof(NumberTUnsigned)
     );
 }
 
+/**
+ * @brief Write a number to a BinaryWriter
+ * @tparam NumberT (signed) input number type
+ * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
+ * @param value Value of the number in NumberT
+ * @param out BinaryWriter to write to
+ * @param endianness Endianness to write the number in
+ */
+template<typename NumberT, typename NumberTUnsigned>
+void write_number(NumberT value, BinaryWriter &writer, Endianness endianness)
+{
+    if (endianness == Endianness::Big) write_number<Endianness::Big, NumberT, NumberTUnsigned>(value, writer);
+    else write_number<Endianness::Little, NumberT, NumberTUnsigned>(value, writer);
+}
+
+/**
+ * @brief Write any number of bytes to a BinaryWriter, in pieces of at most UINT32_MAX bytes
+ * @param writer BinaryWriter to write to
+ * @param data Bytes to write
+ * @param size Number of bytes to write
+ */
+inline void write_bytes(BinaryWriter &writer, const char *data, std::size_t size)
+{
+    while (size > UINT32_MAX) {
+        writer.write(data, UINT32_MAX);
+        data += UINT32_MAX;
+        size -= UINT32_MAX;
+    }
+    writer.write(data, static_cast<std::uint32_t>(size));
+}
+
+/**
+ * @brief Read any number of bytes from a BinaryReader, in pieces of at most UINT32_MAX bytes
+ * @param reader BinaryReader to read from
+ * @param data Buffer to read into
+ * @param size Number of bytes to read
+ */
+inline void read_bytes(BinaryReader &reader, char *data, std::size_t size)
+{
+    while (size > UINT32_MAX) {
+        reader.read(data, UINT32_MAX);
+        data += UINT32_MAX;
+        size -= UINT32_MAX;
+    }
+    reader.read(data, static_cast<std::uint32_t>(size));
+}
+
+/**
+ * @brief Write an array of numbers to a BinaryWriter in one go
+ * @tparam NumberT (signed) input number type
+ * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
+ * @param values Numbers to write
+ * @param count Number of numbers to write
+ * @param writer BinaryWriter to write to
+ * @param endianness Endianness to write the numbers in
+ */
+template<typename NumberT, typename NumberTUnsigned>
+void write_numbers(const NumberT *values, std::size_t count, BinaryWriter &writer, Endianness endianness)
+{
+    static_assert(sizeof(NumberT) == sizeof(NumberTUnsigned), "NumberT and NumberTUnsigned must have the same size");
+
+    if (sizeof(NumberT) == 1 || endianness == SYSTEM_ENDIANNESS) {
+        write_bytes(writer, reinterpret_cast<const char *>(values), count * sizeof(NumberT));
+        return;
+    }
+
+    // Swap through a fixed buffer instead of writing number by number
+    NumberTUnsigned buffer[CHUNK / sizeof(NumberT)];
+    const auto buffer_count = sizeof(buffer) / sizeof(NumberT);
+    for (std::size_t done = 0; done < count; done += buffer_count) {
+        auto n = count - done < buffer_count ? count - done : buffer_count;
+        std::memcpy(buffer, values + done, n * sizeof(NumberT));
+        swap_bytes(buffer, n, sizeof(NumberT));
+        writer.write(reinterpret_cast<const char *>(buffer), static_cast<std::uint32_t>(n * sizeof(NumberT)));
+    }
+}
+
+/**
+ * @brief Write a string to a BinaryWriter, in an endianness known at compile time
+ * @tparam E Endianness to write the string's length in
+ * @param str String to write
+ * @param writer BinaryWriter to write to
+ */
+template<Endianness E>
+void write_string(const std::string &str, BinaryWriter &writer)
+{
+    write_number<E, std::uint16_t, std::uint16_t>(static_cast<std::uint16_t>(str.size()), writer);
+    writer.write(str.data(), static_cast<std::uint16_t>(str.size()));
+}
+
 /**
  * @brief Write a string to a BinaryWriter
  * @param str String to write
@@ -79,30 +192,78 @@ void write_number(NumberT value, BinaryWriter &writer, Endianness endianness)
 void write_string(const std::string &str, BinaryWriter &writer, Endianness endianness);
 
 /**
- * @brief Read a number from a BinaryReader
+ * @brief Read a number from a BinaryReader, in an endianness known at compile time
+ * @tparam E Endianness to read the number in
  * @tparam NumberT (signed) number type
  * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
- * @param in BinaryReader to read from
- * @param endianness Endianness to read the number in
+ * @param reader BinaryReader to read from
  * @return Read number
  */
-template<typename NumberT, typename NumberTUnsigned>
-auto read_number(BinaryReader &reader, Endianness endianness)
+template<Endianness E, typename NumberT, typename NumberTUnsigned>
+NumberT read_number(BinaryReader &reader)
 {
     static_assert(sizeof(NumberT) == sizeof(NumberTUnsigned), "NumberT and NumberTUnsigned must have the same size");
 
     auto converter = ConvertToChars<NumberTUnsigned>{0};
     reader.read(converter.chars, sizeof(NumberTUnsigned));
     auto result = Convert<NumberTUnsigned, NumberT>{
-        optional_reverse_uint(
-            converter.int_type,
-            endianness
+        optional_reverse_uint<E>(
+            converter.int_type
         )
     };
 
     return result.b;
 }
 
+/**
+ * @brief Read a number from a BinaryReader
+ * @tparam NumberT (signed) number type
+ * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
+ * @param in BinaryReader to read from
+ * @param endianness Endianness to read the number in
+ * @return Read number
+ */
+template<typename NumberT, typename NumberTUnsigned>
+auto read_number(BinaryReader &reader, Endianness endianness)
+{
+    return endianness == Endianness::Big ? read_number<Endianness::Big, NumberT, NumberTUnsigned>(reader)
+                                         : read_number<Endianness::Little, NumberT, NumberTUnsigned>(reader);
+}
+
+/**
+ * @brief Read an array of numbers from a BinaryReader in one go
+ * @tparam NumberT (signed) number type
+ * @tparam NumberTUnsigned Unsigned version of NumberT (can also be the same if NumberT is already unsigned)
+ * @param reader BinaryReader to read from
+ * @param values Array to read the numbers into
+ * @param count Number of numbers to read
+ * @param endianness Endianness to read the numbers in
+ */
+template<typename NumberT, typename NumberTUnsigned>
+void read_numbers(BinaryReader &reader, NumberT *values, std::size_t count, Endianness endianness)
+{
+    static_assert(sizeof(NumberT) == sizeof(NumberTUnsigned), "NumberT and NumberTUnsigned must have the same size");
+
+    read_bytes(reader, reinterpret_cast<char *>(values), count * sizeof(NumberT));
+    if (sizeof(NumberT) == 1 || endianness == SYSTEM_ENDIANNESS) return;
+    swap_bytes(values, count, sizeof(NumberT));
+}
+
+/**
+ * @brief Read a string from a BinaryReader, in an endianness known at compile time
+ * @tparam E Endianness to read the string's length in
+ * @param reader BinaryReader to read from
+ * @return Read string
+ */
+template<Endianness E>
+std::string read_string(BinaryReader &reader)
+{
+    auto len = read_number<E, std::uint16_t, std::uint16_t>(reader);
+    auto res = std::string(len, ' ');
+    reader.read(&res[0], len);
+    return res;
+}
+
 /**
  * @brief Read a string from a BinaryReader
  * @param in BinaryReader to read from
@@ -111,6 +272,31 @@ auto read_number(BinaryReader &reader, Endianness endianness)
  */
 std::string read_string(BinaryReader &reader, Endianness endianness);
 
+/**
+ * @brief Read a string from a BinaryReader as an interned Key, in an endianness known at compile time
+ * @tparam E Endianness to read the string's length in
+ * @param reader BinaryReader to read from
+ * @return Read string as Key
+ */
+template<Endianness E>
+Key read_key(BinaryReader &reader)
+{
+    // Names are read into a reused buffer, so a name that is already interned costs no allocation
+    thread_local std::string buffer;
+    auto len = read_number<E, std::uint16_t, std::uint16_t>(reader);
+    buffer.resize(len);
+    reader.read(&buffer[0], len);
+    return Key{buffer.data(), buffer.size()};
+}
+
+/**
+ * @brief Read a string from a BinaryReader as an interned Key
+ * @param reader BinaryReader to read from
+ * @param endianness Endianness to read the string's length in
+ * @return Read string as Key
+ */
+Key read_key(BinaryReader &reader, Endianness endianness);
+
 /**
  * @brief Write a TagType (tag id) to a BinaryWriter
  * @param type TagType to write (tag id)
@@ -130,9 +316,59 @@ TagType read_tag_id(BinaryReader &reader);
  * @param type Tag type (tag id) of the tag to read
  * @param in BinaryReader to read the tag from
  * @param endianness Endianness to read the tag in
+ * @param options Options for reading the tag
+ * @param projection Part of the tag to build (nullptr builds all of it, or what ReadOptions::paths selects)
  * @return Resulting tag as Tag *
  */
-Tag *read_tag(TagType type, BinaryReader &reader, Endianness endianness);
+Tag *read_tag(TagType type, BinaryReader &reader, Endianness endianness, const ReadOptions &options = ReadOptions{},
+              const Projection *projection = nullptr);
+
+/**
+ * @brief Read a tag, in an endianness known at compile time (the entry points taking an Endianness dispatch to this)
+ * @tparam E Endianness to read the tag in
+ * @param type Tag type (tag id) of the tag to read
+ * @param reader BinaryReader to read the tag from
+ * @param options Options for reading the tag
+ * @param projection Part of the tag to build (nullptr builds all of it, or what ReadOptions::paths selects)
+ * @return Resulting tag as Tag *
+ */
+template<Endianness E>
+Tag *read_tag(TagType type, BinaryReader &reader, const ReadOptions &options = ReadOptions{},
+              const Projection *projection = nullptr);
+
+/**
+ * @brief Read a TAG_List, as a NumberListTag if it holds numbers and ReadOptions::typed_lists is set
+ * @param reader BinaryReader to read the list from
+ * @param endianness Endianness to read the list in
+ * @param options Options for reading the list
+ * @param projection Part of the list to build (nullptr builds all of it)
+ * @return Resulting TagList or NumberListTag as Tag *
+ */
+Tag *read_list(BinaryReader &reader, Endianness endianness, const ReadOptions &options,
+               const Projection *projection = nullptr);
+
+/**
+ * @brief Read a TAG_List, in an endianness known at compile time
+ * @tparam E Endianness to read the list in
+ * @param reader BinaryReader to read the list from
+ * @param options Options for reading the list
+ * @param projection Part of the list to build (nullptr builds all of it)
+ * @return Resulting TagList or NumberListTag as Tag *
+ */
+template<Endianness E>
+Tag *read_list(BinaryReader &reader, const ReadOptions &options, const Projection *projection = nullptr);
+
+/**
+ * @brief Advance a BinaryReader past the payload of a tag without parsing or allocating anything
+ *
+ * Compounds and lists are walked with an explicit stack instead of recursion, strings, arrays and lists of fixed-size
+ * numbers are passed over in one BinaryReader::skip() call, which is O(1) for a BufferReader or MmapReader.
+ * @param type Tag type (tag id) of the tag to skip
+ * @param reader BinaryReader positioned at the payload of the tag
+ * @param endianness Endianness of the tag
+ * @throws std::runtime_error If the tag is malformed or nested deeper than MAX_SKIP_DEPTH
+ */
+void skip_tag(TagType type, BinaryReader &reader, Endianness endianness);
 
 /**
  * @fn tag_type_to_string
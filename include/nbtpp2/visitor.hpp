@@ -0,0 +1,115 @@
+#ifndef NBTPP2_VISITOR_HPP
+#define NBTPP2_VISITOR_HPP
+
+#include <nbtpp2/endianness.hpp>
+#include <nbtpp2/io.hpp>
+#include <nbtpp2/tag_type.hpp>
+
+#include <cstdint>
+#include <string>
+
+namespace nbtpp2
+{
+
+/**
+ * @class NbtVisitor
+ * @brief Receives the contents of an NBT file as a stream of events, see visit()
+ *
+ * Every callback does nothing by default, so a visitor only overrides the events it is interested in.
+ * Names, strings and arrays passed to the callbacks are only valid during the callback.
+ * Elements of a list have an empty name.
+ */
+class NbtVisitor
+{
+public:
+    virtual ~NbtVisitor() = default;
+
+    /**
+     * @brief Called at the start of a TAG_Compound
+     * @param name Name of the compound
+     */
+    virtual void begin_compound(const std::string &/*name*/)
+    {}
+
+    /// @brief Called at the end of a TAG_Compound
+    virtual void end_compound()
+    {}
+
+    /**
+     * @brief Called at the start of a TAG_List
+     * @param name Name of the list
+     * @param element_type Tag type of the elements
+     * @param length Number of elements
+     */
+    virtual void begin_list(const std::string &/*name*/, TagType /*element_type*/, std::int32_t /*length*/)
+    {}
+
+    /// @brief Called at the end of a TAG_List
+    virtual void end_list()
+    {}
+
+    /**
+     * @brief Called for a TAG_Byte
+     * @param name Name of the tag
+     * @param value Value of the tag
+     */
+    virtual void value(const std::string &/*name*/, std::int8_t /*value*/)
+    {}
+
+    /// @brief Called for a TAG_Short @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, std::int16_t /*value*/)
+    {}
+
+    /// @brief Called for a TAG_Int @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, std::int32_t /*value*/)
+    {}
+
+    /// @brief Called for a TAG_Long @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, std::int64_t /*value*/)
+    {}
+
+    /// @brief Called for a TAG_Float @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, float /*value*/)
+    {}
+
+    /// @brief Called for a TAG_Double @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, double /*value*/)
+    {}
+
+    /// @brief Called for a TAG_String @copydetails value(const std::string &, std::int8_t)
+    virtual void value(const std::string &/*name*/, const std::string &/*value*/)
+    {}
+
+    /**
+     * @brief Called for a TAG_Byte_Array
+     * @param name Name of the tag
+     * @param data Elements of the array
+     * @param size Number of elements
+     */
+    virtual void array(const std::string &/*name*/, const std::int8_t * /*data*/, std::size_t /*size*/)
+    {}
+
+    /// @brief Called for a TAG_Int_Array @copydetails array(const std::string &, const std::int8_t *, std::size_t)
+    virtual void array(const std::string &/*name*/, const std::int32_t * /*data*/, std::size_t /*size*/)
+    {}
+
+    /// @brief Called for a TAG_Long_Array @copydetails array(const std::string &, const std::int8_t *, std::size_t)
+    virtual void array(const std::string &/*name*/, const std::int64_t * /*data*/, std::size_t /*size*/)
+    {}
+};
+
+/**
+ * @brief Parse an NBT file from a BinaryReader, passing its contents to a visitor without creating any tags
+ *
+ * Strings and arrays are read into buffers that are reused for the whole file, byte arrays are passed straight from
+ * the buffer of a BufferReader.
+ * @param reader BinaryReader to read the file from
+ * @param endianness Endianness of the file
+ * @param visitor Visitor receiving the contents of the file, starting with begin_compound() for the root tag
+ * @throws std::runtime_error If the file is malformed or nested deeper than MAX_SKIP_DEPTH
+ */
+void visit(BinaryReader &reader, Endianness endianness, NbtVisitor &visitor);
+
+}
+
+#endif //NBTPP2_VISITOR_HPP
@@ -0,0 +1,234 @@
+#include <nbtpp2/arena.hpp>
+
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <mutex>
+#include <new>
+
+#if defined(_WIN32)
+#include <malloc.h>
+#endif
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+static_assert((ARENA_BLOCK_SIZE & (ARENA_BLOCK_SIZE - 1)) == 0, "ARENA_BLOCK_SIZE must be a power of two");
+
+thread_local Arena *active_arena = nullptr;
+
+/// Slot values of a GranuleTable that are not the address of a granule
+const std::uintptr_t EMPTY_SLOT = 0;
+const std::uintptr_t REMOVED_SLOT = 1;
+
+/**
+ * Open-addressing set of the granules (ARENA_BLOCK_SIZE-aligned pieces) of all arena blocks, by address. Readers only
+ * load slots, so they never lock; writers hold {@link granules_mutex}, and never let the table fill up more than half.
+ */
+struct GranuleTable
+{
+    std::size_t mask;
+    std::unique_ptr<std::atomic<std::uintptr_t>[]> slots;
+
+    explicit GranuleTable(std::size_t capacity)
+        : mask{capacity - 1}, slots{new std::atomic<std::uintptr_t>[capacity]}
+    {
+        for (std::size_t i = 0; i < capacity; ++i) {
+            slots[i].store(EMPTY_SLOT, std::memory_order_relaxed);
+        }
+    }
+
+    std::size_t first_slot(std::uintptr_t granule) const
+    {
+        auto hash = static_cast<std::uint64_t>(granule / ARENA_BLOCK_SIZE) * 0x9E3779B97F4A7C15u;
+        return static_cast<std::size_t>(hash >> 32u) & mask;
+    }
+};
+
+std::mutex granules_mutex;
+
+/// The current table
+std::atomic<GranuleTable *> granules{nullptr};
+
+/// Every table that was ever current, as readers may still be using a replaced one
+std::vector<std::unique_ptr<GranuleTable>> granule_tables;
+
+/// Number of non-empty slots in the current table (granules and removed granules)
+std::size_t granule_slots_used = 0;
+
+/// Number of granules in the current table, read without locking so that heap-only programs never look them up
+std::atomic<std::size_t> granule_count{0};
+
+/// Replace the current table by one with room for at least count granules (with {@link granules_mutex} held)
+void rebuild_granules(std::size_t count)
+{
+    std::size_t capacity = 64;
+    while (capacity < count * 4) capacity *= 2;
+    auto table = std::unique_ptr<GranuleTable>{new GranuleTable{capacity}};
+    auto old = granules.load(std::memory_order_relaxed);
+    if (old != nullptr) {
+        for (std::size_t i = 0; i <= old->mask; ++i) {
+            auto granule = old->slots[i].load(std::memory_order_relaxed);
+            if (granule == EMPTY_SLOT || granule == REMOVED_SLOT) continue;
+            auto slot = table->first_slot(granule);
+            while (table->slots[slot].load(std::memory_order_relaxed) != EMPTY_SLOT) slot = (slot + 1) & table->mask;
+            table->slots[slot].store(granule, std::memory_order_relaxed);
+        }
+    }
+    granule_slots_used = granule_count.load(std::memory_order_relaxed);
+    granule_tables.reserve(granule_tables.size() + 1);
+    granules.store(table.get(), std::memory_order_release);
+    granule_tables.push_back(std::move(table));
+}
+
+/// Register the granules of a block
+void add_granules(const char *block, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock{granules_mutex};
+    auto count = size / ARENA_BLOCK_SIZE;
+    auto table = granules.load(std::memory_order_relaxed);
+    if (table == nullptr || (granule_slots_used + count) * 2 > table->mask + 1) {
+        rebuild_granules(granule_count.load(std::memory_order_relaxed) + count);
+        table = granules.load(std::memory_order_relaxed);
+    }
+
+    for (std::size_t i = 0; i < count; ++i) {
+        auto granule = reinterpret_cast<std::uintptr_t>(block) + i * ARENA_BLOCK_SIZE;
+        auto slot = table->first_slot(granule);
+        for (;; slot = (slot + 1) & table->mask) {
+            auto value = table->slots[slot].load(std::memory_order_relaxed);
+            if (value == EMPTY_SLOT) ++granule_slots_used;
+            if (value == EMPTY_SLOT || value == REMOVED_SLOT) break;
+        }
+        table->slots[slot].store(granule, std::memory_order_release);
+    }
+    granule_count.fetch_add(count, std::memory_order_release);
+}
+
+/// Unregister the granules of a block (granules that were never registered are skipped)
+void remove_granules(const char *block, std::size_t size)
+{
+    std::lock_guard<std::mutex> lock{granules_mutex};
+    auto table = granules.load(std::memory_order_relaxed);
+    if (table == nullptr) return;
+
+    for (std::size_t i = 0; i < size / ARENA_BLOCK_SIZE; ++i) {
+        auto granule = reinterpret_cast<std::uintptr_t>(block) + i * ARENA_BLOCK_SIZE;
+        for (auto slot = table->first_slot(granule);; slot = (slot + 1) & table->mask) {
+            auto value = table->slots[slot].load(std::memory_order_relaxed);
+            if (value == EMPTY_SLOT) break;
+            if (value == granule) {
+                // Removed slots keep the probe sequences of other granules intact
+                table->slots[slot].store(REMOVED_SLOT, std::memory_order_release);
+                granule_count.fetch_sub(1, std::memory_order_release);
+                break;
+            }
+        }
+    }
+}
+
+}
+
+void Arena::FreeBlock::operator()(char *block) const
+{
+#if defined(_WIN32)
+    _aligned_free(block);
+#else
+    std::free(block);
+#endif
+}
+
+Arena::Arena(std::size_t block_size)
+    : block_size{block_size}
+{}
+
+Arena::~Arena()
+{
+    // The blocks themselves are freed after this, when the lists are destroyed
+    for (auto list : {&blocks, &large_blocks}) {
+        for (auto &block : *list) {
+            remove_granules(block.get(), block.get_deleter().size);
+        }
+    }
+}
+
+char *Arena::add_block(std::vector<Block> &list, std::size_t size)
+{
+    size = (size + ARENA_BLOCK_SIZE - 1) / ARENA_BLOCK_SIZE * ARENA_BLOCK_SIZE;
+#if defined(_WIN32)
+    auto memory = _aligned_malloc(size, ARENA_BLOCK_SIZE);
+#else
+    void *memory = nullptr;
+    if (posix_memalign(&memory, ARENA_BLOCK_SIZE, size) != 0) memory = nullptr;
+#endif
+    if (memory == nullptr) throw std::bad_alloc{};
+
+    auto block = Block{static_cast<char *>(memory), FreeBlock{size}};
+    list.push_back(std::move(block));
+    add_granules(list.back().get(), size);
+    return list.back().get();
+}
+
+void *Arena::allocate(std::size_t size, std::size_t alignment)
+{
+    used += size;
+    if (size > block_size) {
+        // Blocks are suitably aligned, and the current block can still be filled up
+        return add_block(large_blocks, size);
+    }
+
+    auto padding = (alignment - reinterpret_cast<std::uintptr_t>(cursor) % alignment) % alignment;
+    if (cursor == nullptr || padding + size > remaining) {
+        cursor = add_block(blocks, block_size);
+        remaining = block_size;
+        padding = 0;
+    }
+
+    auto result = cursor + padding;
+    cursor += padding + size;
+    remaining -= padding + size;
+    return result;
+}
+
+std::size_t Arena::bytes_used() const
+{
+    return used;
+}
+
+std::size_t Arena::block_count() const
+{
+    return blocks.size() + large_blocks.size();
+}
+
+Arena *Arena::current()
+{
+    return active_arena;
+}
+
+bool Arena::owns(const void *ptr)
+{
+    if (granule_count.load(std::memory_order_acquire) == 0) return false;
+    auto table = granules.load(std::memory_order_acquire);
+    auto granule = reinterpret_cast<std::uintptr_t>(ptr) & ~static_cast<std::uintptr_t>(ARENA_BLOCK_SIZE - 1);
+    for (auto slot = table->first_slot(granule);; slot = (slot + 1) & table->mask) {
+        auto value = table->slots[slot].load(std::memory_order_acquire);
+        if (value == granule) return true;
+        if (value == EMPTY_SLOT) return false;
+    }
+}
+
+ArenaScope::ArenaScope(Arena *arena)
+    : previous{active_arena}
+{
+    active_arena = arena;
+}
+
+ArenaScope::~ArenaScope()
+{
+    active_arena = previous;
+}
+
+}
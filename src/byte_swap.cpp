@@ -0,0 +1,177 @@
+#include <nbtpp2/byte_swap.hpp>
+
+#include <cstdint>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(_M_X64) || defined(__i386__) || defined(_M_IX86)
+#   define NBTPP2_SWAP_X86
+#   include <immintrin.h>
+#   if defined(_MSC_VER)
+#       include <intrin.h>
+#   endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#   define NBTPP2_SWAP_NEON
+#   include <arm_neon.h>
+#endif
+
+// Compile single functions for instruction sets the rest of the library is not built for
+#if defined(NBTPP2_SWAP_X86) && (defined(__GNUC__) || defined(__clang__))
+#   define NBTPP2_TARGET(isa) __attribute__((target(isa)))
+#else
+#   define NBTPP2_TARGET(isa)
+#endif
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+template<typename UintT>
+void swap_scalar(char *data, std::size_t count)
+{
+    for (std::size_t i = 0; i < count; ++i) {
+        UintT number;
+        std::memcpy(&number, data + i * sizeof(number), sizeof(number));
+        number = byte_swap(number);
+        std::memcpy(data + i * sizeof(number), &number, sizeof(number));
+    }
+}
+
+void swap_scalar(char *data, std::size_t count, std::size_t size)
+{
+    switch (size) {
+    case 2: swap_scalar<std::uint16_t>(data, count);
+        return;
+    case 4: swap_scalar<std::uint32_t>(data, count);
+        return;
+    case 8: swap_scalar<std::uint64_t>(data, count);
+        return;
+    default: return;
+    }
+}
+
+#if defined(NBTPP2_SWAP_X86)
+
+/// Shuffle masks reversing 2, 4 and 8 byte numbers, for both 128-bit lanes of an AVX2 register
+alignas(32) const std::uint8_t SHUFFLE_MASKS[3][32] = {
+    {1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14, 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14},
+    {3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12, 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12},
+    {7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8},
+};
+
+const std::uint8_t *shuffle_mask(std::size_t size)
+{
+    return SHUFFLE_MASKS[size == 2 ? 0 : size == 4 ? 1 : 2];
+}
+
+NBTPP2_TARGET("ssse3")
+void swap_ssse3(char *data, std::size_t count, std::size_t size)
+{
+    auto mask = _mm_load_si128(reinterpret_cast<const __m128i *>(shuffle_mask(size)));
+    auto bytes = count * size;
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        auto block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i *>(data + i), _mm_shuffle_epi8(block, mask));
+    }
+    swap_scalar(data + i, (bytes - i) / size, size);
+}
+
+NBTPP2_TARGET("avx2")
+void swap_avx2(char *data, std::size_t count, std::size_t size)
+{
+    auto mask = _mm256_load_si256(reinterpret_cast<const __m256i *>(shuffle_mask(size)));
+    auto bytes = count * size;
+    std::size_t i = 0;
+    for (; i + 32 <= bytes; i += 32) {
+        auto block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(data + i), _mm256_shuffle_epi8(block, mask));
+    }
+    swap_scalar(data + i, (bytes - i) / size, size);
+}
+
+bool cpu_supports_avx2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+    __cpuid(info, 1);
+    // AVX needs OS support for saving the YMM registers
+    auto osxsave_avx = (1 << 27) | (1 << 28);
+    if ((info[2] & osxsave_avx) != osxsave_avx || (_xgetbv(0) & 6) != 6) return false;
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    return __builtin_cpu_supports("avx2");
+#endif
+}
+
+bool cpu_supports_ssse3()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 9)) != 0;
+#else
+    return __builtin_cpu_supports("ssse3");
+#endif
+}
+
+#elif defined(NBTPP2_SWAP_NEON)
+
+void swap_neon(char *data, std::size_t count, std::size_t size)
+{
+    auto bytes = count * size;
+    auto bytes_ptr = reinterpret_cast<std::uint8_t *>(data);
+    std::size_t i = 0;
+    for (; i + 16 <= bytes; i += 16) {
+        auto block = vld1q_u8(bytes_ptr + i);
+        block = size == 2 ? vrev16q_u8(block) : size == 4 ? vrev32q_u8(block) : vrev64q_u8(block);
+        vst1q_u8(bytes_ptr + i, block);
+    }
+    swap_scalar(data + i, (bytes - i) / size, size);
+}
+
+#endif
+
+using SwapFunction = void (*)(char *data, std::size_t count, std::size_t size);
+
+struct SwapImplementation
+{
+    SwapFunction function;
+    const char *name;
+};
+
+SwapImplementation select_implementation()
+{
+#if defined(NBTPP2_SWAP_X86)
+    if (cpu_supports_avx2()) return {swap_avx2, "avx2"};
+    if (cpu_supports_ssse3()) return {swap_ssse3, "ssse3"};
+#elif defined(NBTPP2_SWAP_NEON)
+    return {swap_neon, "neon"};
+#endif
+    return {static_cast<SwapFunction>(swap_scalar), "scalar"};
+}
+
+const SwapImplementation &implementation()
+{
+    static const auto selected = select_implementation();
+    return selected;
+}
+
+}
+
+void swap_bytes(void *data, std::size_t count, std::size_t size)
+{
+    if (size != 2 && size != 4 && size != 8) return;
+    implementation().function(static_cast<char *>(data), count, size);
+}
+
+const char *swap_bytes_implementation()
+{
+    return implementation().name;
+}
+
+}
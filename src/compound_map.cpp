@@ -0,0 +1,455 @@
+#include <nbtpp2/compound_map.hpp>
+#include <nbtpp2/lazy_tag.hpp>
+
+#include <algorithm>
+#include <stdexcept>
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+bool entry_less(const CompoundMap::value_type &entry, const std::string &key)
+{
+    return entry.first.str() < key;
+}
+
+}
+
+CompoundMap::CompoundMap(std::initializer_list<value_type> entries, Order order)
+    : order{order}
+{
+    reserve(entries.size());
+    for (const auto &entry : entries) {
+        insert(entry);
+    }
+}
+
+CompoundMap::CompoundMap(const std::map<std::string, Tag *> &map)
+{
+    entries.reserve(map.size());
+    for (const auto &entry : map) {
+        entries.emplace_back(Key{entry.first}, entry.second);
+    }
+    rebuild_index();
+}
+
+std::size_t CompoundMap::locate(const Key &key) const
+{
+    if (!index.empty()) {
+        auto mask = index.size() - 1;
+        for (auto i = key.hash() & mask;; i = (i + 1) & mask) {
+            const auto &slot = index[i];
+            if (slot.entry == 0) return entries.size();
+            if (entries[slot.entry - 1].first == key) return slot.entry - 1;
+        }
+    }
+
+    // Comparing pointers beats a binary search on the few entries of a small map
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].first == key) return i;
+    }
+    return entries.size();
+}
+
+std::size_t CompoundMap::locate(const std::string &key) const
+{
+    if (!index.empty()) {
+        auto key_hash = nbtpp2::key_hash(key.data(), key.size());
+        auto mask = index.size() - 1;
+        for (auto i = key_hash & mask;; i = (i + 1) & mask) {
+            const auto &slot = index[i];
+            if (slot.entry == 0) return entries.size();
+            if (slot.hash == key_hash && entries[slot.entry - 1].first == key) return slot.entry - 1;
+        }
+    }
+
+    if (order == Order::Sorted) {
+        auto it = std::lower_bound(entries.begin(), entries.end(), key, entry_less);
+        if (it != entries.end() && it->first == key) return static_cast<std::size_t>(it - entries.begin());
+        return entries.size();
+    }
+
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        if (entries[i].first == key) return i;
+    }
+    return entries.size();
+}
+
+std::size_t CompoundMap::resolve(std::size_t position) const
+{
+    if (position >= lazy.size() || !lazy[position]) return position;
+    auto &tag = entries[position].second;
+    auto unparsed = static_cast<LazyTag *>(tag);
+    tag = unparsed->materialize();
+    lazy[position] = false;
+    delete unparsed;
+    return position;
+}
+
+std::size_t CompoundMap::insert_new(Key key, Tag *tag)
+{
+    auto position = entries.size();
+    if (order == Order::Sorted && !entries.empty() && !(entries.back().first < key)) {
+        position = static_cast<std::size_t>(
+            std::lower_bound(entries.begin(), entries.end(), key.str(), entry_less) - entries.begin());
+    }
+    entries.emplace(entries.begin() + position, key, tag);
+    if (!lazy.empty()) lazy.insert(lazy.begin() + position, false);
+
+    if (entries.size() < COMPOUND_HASH_THRESHOLD) return position;
+    // Keep the index at most half full
+    if (index.size() < 2 * entries.size()) {
+        rebuild_index();
+        return position;
+    }
+    if (position + 1 != entries.size()) {
+        for (auto &slot : index) {
+            if (slot.entry > position) ++slot.entry;
+        }
+    }
+    index_entry(position);
+    return position;
+}
+
+void CompoundMap::rebuild_index()
+{
+    index.clear();
+    if (entries.size() < COMPOUND_HASH_THRESHOLD) return;
+
+    std::size_t capacity = 2 * COMPOUND_HASH_THRESHOLD;
+    while (capacity < 4 * entries.size()) capacity *= 2;
+    index.assign(capacity, Slot{0, 0});
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        index_entry(i);
+    }
+}
+
+void CompoundMap::sort_entries()
+{
+    if (lazy.empty()) {
+        std::stable_sort(entries.begin(), entries.end(),
+                         [](const value_type &a, const value_type &b) { return a.first < b.first; });
+        return;
+    }
+
+    // Sort the entries and their lazy flags together
+    auto positions = std::vector<std::size_t>(entries.size());
+    for (std::size_t i = 0; i < positions.size(); ++i) positions[i] = i;
+    std::stable_sort(positions.begin(), positions.end(),
+                     [this](std::size_t a, std::size_t b) { return entries[a].first < entries[b].first; });
+    auto sorted_entries = std::vector<value_type>{};
+    auto sorted_lazy = std::vector<bool>{};
+    sorted_entries.reserve(entries.size());
+    sorted_lazy.reserve(entries.size());
+    for (auto position : positions) {
+        sorted_entries.push_back(entries[position]);
+        sorted_lazy.push_back(lazy[position]);
+    }
+    entries.swap(sorted_entries);
+    lazy.swap(sorted_lazy);
+}
+
+void CompoundMap::index_entry(std::size_t position)
+{
+    auto key_hash = entries[position].first.hash();
+    auto mask = index.size() - 1;
+    auto i = key_hash & mask;
+    while (index[i].entry != 0) i = (i + 1) & mask;
+    index[i] = Slot{key_hash, static_cast<std::uint32_t>(position + 1)};
+}
+
+Tag *&CompoundMap::operator[](const Key &key)
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) position = insert_new(key, nullptr);
+    return entries[position].second;
+}
+
+Tag *&CompoundMap::operator[](const std::string &key)
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) position = insert_new(Key{key}, nullptr);
+    return entries[position].second;
+}
+
+Tag *&CompoundMap::operator[](const char *key)
+{
+    return (*this)[Key{key}];
+}
+
+Tag *&CompoundMap::at(const Key &key)
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) throw std::out_of_range("no tag with name " + key.str() + " in compound");
+    return entries[position].second;
+}
+
+Tag *&CompoundMap::at(const std::string &key)
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) throw std::out_of_range("no tag with name " + key + " in compound");
+    return entries[position].second;
+}
+
+Tag *&CompoundMap::at(const char *key)
+{
+    return at(Key{key});
+}
+
+Tag *const &CompoundMap::at(const Key &key) const
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) throw std::out_of_range("no tag with name " + key.str() + " in compound");
+    return entries[position].second;
+}
+
+Tag *const &CompoundMap::at(const std::string &key) const
+{
+    auto position = resolve(locate(key));
+    if (position == entries.size()) throw std::out_of_range("no tag with name " + key + " in compound");
+    return entries[position].second;
+}
+
+Tag *const &CompoundMap::at(const char *key) const
+{
+    return at(Key{key});
+}
+
+CompoundMap::iterator CompoundMap::find(const Key &key)
+{
+    return entries.begin() + resolve(locate(key));
+}
+
+CompoundMap::iterator CompoundMap::find(const std::string &key)
+{
+    return entries.begin() + resolve(locate(key));
+}
+
+CompoundMap::iterator CompoundMap::find(const char *key)
+{
+    return find(Key{key});
+}
+
+CompoundMap::const_iterator CompoundMap::find(const Key &key) const
+{
+    return entries.begin() + resolve(locate(key));
+}
+
+CompoundMap::const_iterator CompoundMap::find(const std::string &key) const
+{
+    return entries.begin() + resolve(locate(key));
+}
+
+CompoundMap::const_iterator CompoundMap::find(const char *key) const
+{
+    return find(Key{key});
+}
+
+CompoundMap::size_type CompoundMap::count(const Key &key) const
+{
+    return locate(key) == entries.size() ? 0 : 1;
+}
+
+CompoundMap::size_type CompoundMap::count(const std::string &key) const
+{
+    return locate(key) == entries.size() ? 0 : 1;
+}
+
+CompoundMap::size_type CompoundMap::count(const char *key) const
+{
+    return count(Key{key});
+}
+
+std::pair<CompoundMap::iterator, bool> CompoundMap::insert(value_type entry)
+{
+    return emplace(entry.first, entry.second);
+}
+
+std::pair<CompoundMap::iterator, bool> CompoundMap::emplace(Key key, Tag *tag)
+{
+    auto position = locate(key);
+    if (position != entries.size()) return {entries.begin() + position, false};
+    position = insert_new(key, tag);
+    return {entries.begin() + position, true};
+}
+
+void CompoundMap::set_lazy(const Key &key, Tag *tag)
+{
+    auto position = locate(key);
+    if (position == entries.size()) position = insert_new(key, tag);
+    else entries[position].second = tag;
+    if (lazy.empty()) lazy.assign(entries.size(), false);
+    lazy[position] = true;
+}
+
+void CompoundMap::append(Key key, Tag *tag, bool unparsed)
+{
+    entries.emplace_back(std::move(key), tag);
+    if (!lazy.empty()) {
+        lazy.push_back(unparsed);
+    }
+    else if (unparsed) {
+        lazy.assign(entries.size(), false);
+        lazy.back() = true;
+    }
+}
+
+std::vector<Tag *> CompoundMap::finish_append()
+{
+    auto replaced = std::vector<Tag *>{};
+    auto kept = std::size_t{0};
+    auto keep = [&](std::size_t position, std::size_t existing)
+    {
+        if (existing != kept) {
+            replaced.push_back(entries[existing].second);
+            entries[existing].second = entries[position].second;
+            if (!lazy.empty()) lazy[existing] = lazy[position];
+            return false;
+        }
+        if (kept != position) {
+            entries[kept] = std::move(entries[position]);
+            if (!lazy.empty()) lazy[kept] = lazy[position];
+        }
+        ++kept;
+        return true;
+    };
+
+    // Find duplicates among the entries kept so far, through a fresh index if the map is big enough to get one
+    index.clear();
+    if (entries.size() >= COMPOUND_HASH_THRESHOLD) {
+        std::size_t capacity = 2 * COMPOUND_HASH_THRESHOLD;
+        while (capacity < 4 * entries.size()) capacity *= 2;
+        index.assign(capacity, Slot{0, 0});
+        auto mask = index.size() - 1;
+        for (std::size_t position = 0; position < entries.size(); ++position) {
+            auto key_hash = entries[position].first.hash();
+            auto i = key_hash & mask;
+            while (index[i].entry != 0 && !(entries[index[i].entry - 1].first == entries[position].first)) {
+                i = (i + 1) & mask;
+            }
+            auto existing = index[i].entry != 0 ? index[i].entry - 1 : kept;
+            if (keep(position, existing)) index[i] = Slot{key_hash, static_cast<std::uint32_t>(kept)};
+        }
+    }
+    else {
+        for (std::size_t position = 0; position < entries.size(); ++position) {
+            auto existing = std::size_t{0};
+            while (existing < kept && !(entries[existing].first == entries[position].first)) ++existing;
+            keep(position, existing);
+        }
+    }
+    entries.resize(kept);
+    if (!lazy.empty()) lazy.resize(kept);
+
+    // Files are usually written sorted, which makes this a single pass that keeps the index as it is
+    auto by_name = [](const value_type &a, const value_type &b) { return a.first < b.first; };
+    if (order == Order::Sorted && !std::is_sorted(entries.begin(), entries.end(), by_name)) {
+        sort_entries();
+        rebuild_index();
+    }
+    else if (index.size() < 2 * entries.size() || (!index.empty() && entries.size() < COMPOUND_HASH_THRESHOLD)) {
+        rebuild_index();
+    }
+    return replaced;
+}
+
+CompoundMap::size_type CompoundMap::erase(const Key &key)
+{
+    auto position = locate(key);
+    if (position == entries.size()) return 0;
+    erase(entries.begin() + position);
+    return 1;
+}
+
+CompoundMap::size_type CompoundMap::erase(const std::string &key)
+{
+    auto position = locate(key);
+    if (position == entries.size()) return 0;
+    erase(entries.begin() + position);
+    return 1;
+}
+
+CompoundMap::size_type CompoundMap::erase(const char *key)
+{
+    return erase(Key{key});
+}
+
+CompoundMap::iterator CompoundMap::erase(const_iterator position)
+{
+    auto offset = position - entries.cbegin();
+    entries.erase(entries.begin() + offset);
+    if (!lazy.empty()) lazy.erase(lazy.begin() + offset);
+    rebuild_index();
+    return entries.begin() + offset;
+}
+
+void CompoundMap::clear()
+{
+    entries.clear();
+    lazy.clear();
+    index.clear();
+}
+
+void CompoundMap::reserve(size_type size)
+{
+    entries.reserve(size);
+}
+
+CompoundMap::size_type CompoundMap::size() const
+{
+    return entries.size();
+}
+
+bool CompoundMap::empty() const
+{
+    return entries.empty();
+}
+
+CompoundMap::iterator CompoundMap::begin()
+{
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        resolve(i);
+    }
+    return entries.begin();
+}
+
+CompoundMap::iterator CompoundMap::end()
+{
+    return entries.end();
+}
+
+CompoundMap::const_iterator CompoundMap::begin() const
+{
+    for (std::size_t i = 0; i < entries.size(); ++i) {
+        resolve(i);
+    }
+    return entries.begin();
+}
+
+CompoundMap::const_iterator CompoundMap::end() const
+{
+    return entries.end();
+}
+
+const std::vector<CompoundMap::value_type> &CompoundMap::raw_entries() const
+{
+    return entries;
+}
+
+CompoundMap::Order CompoundMap::get_order() const
+{
+    return order;
+}
+
+void CompoundMap::set_order(Order new_order)
+{
+    if (new_order == Order::Sorted && order != Order::Sorted) {
+        sort_entries();
+        rebuild_index();
+    }
+    order = new_order;
+}
+
+}
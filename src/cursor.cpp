@@ -0,0 +1,211 @@
+#include <nbtpp2/cursor.hpp>
+#include <nbtpp2/util.hpp>
+
+namespace nbtpp2
+{
+
+NbtCursor::NbtCursor(BinaryReader &reader, Endianness endianness)
+    : reader(reader), endianness{endianness}
+{}
+
+void NbtCursor::consume(TagType type)
+{
+    if (!pending) throw std::runtime_error("cursor is not at an unread tag");
+    if (current != type)
+        throw std::runtime_error("cursor is at a " + tag_type_to_string(current) + ", not a " + tag_type_to_string(type));
+    pending = false;
+}
+
+template<Endianness E>
+void NbtCursor::read_list_header(Frame &frame)
+{
+    frame.element_type = read_tag_id(reader);
+    frame.remaining = read_number<E, std::int32_t, std::uint32_t>(reader);
+    if (frame.remaining > 0 && frame.element_type == TagType::TagEnd)
+        throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
+}
+
+template<Endianness E, typename NumberT, typename NumberTUnsigned>
+NumberT NbtCursor::read_value()
+{
+    return read_number<E, NumberT, NumberTUnsigned>(reader);
+}
+
+template<Endianness E, typename NumberT, typename NumberTUnsigned>
+std::vector<NumberT> NbtCursor::read_array()
+{
+    auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+    auto result = std::vector<NumberT>(static_cast<std::size_t>(len < 0 ? 0 : len));
+    read_numbers<NumberT, NumberTUnsigned>(reader, result.data(), result.size(), E);
+    return result;
+}
+
+template<typename NumberT, typename NumberTUnsigned>
+NumberT NbtCursor::read_number_tag(TagType type)
+{
+    consume(type);
+    return endianness == Endianness::Big ? read_value<Endianness::Big, NumberT, NumberTUnsigned>()
+                                         : read_value<Endianness::Little, NumberT, NumberTUnsigned>();
+}
+
+template<typename NumberT, typename NumberTUnsigned>
+std::vector<NumberT> NbtCursor::read_array_tag(TagType type)
+{
+    consume(type);
+    return endianness == Endianness::Big ? read_array<Endianness::Big, NumberT, NumberTUnsigned>()
+                                         : read_array<Endianness::Little, NumberT, NumberTUnsigned>();
+}
+
+template<Endianness E>
+bool NbtCursor::advance()
+{
+    if (frames.empty()) {
+        if (started) return false;
+        started = true;
+        current = read_tag_id(reader);
+        current_name = nbtpp2::read_string<E>(reader);
+        pending = true;
+        return true;
+    }
+
+    auto &frame = frames.back();
+    if (frame.finished) return false;
+    if (frame.container == TagType::TagList) {
+        if (frame.remaining <= 0) {
+            frame.finished = true;
+            return false;
+        }
+        --frame.remaining;
+        current = frame.element_type;
+        current_name.clear();
+        pending = true;
+        return true;
+    }
+
+    current = read_tag_id(reader);
+    if (current == TagType::TagEnd) {
+        frame.finished = true;
+        return false;
+    }
+    current_name = nbtpp2::read_string<E>(reader);
+    pending = true;
+    return true;
+}
+
+bool NbtCursor::next()
+{
+    skip();
+    return endianness == Endianness::Big ? advance<Endianness::Big>() : advance<Endianness::Little>();
+}
+
+TagType NbtCursor::type() const
+{
+    return current;
+}
+
+const std::string &NbtCursor::name() const
+{
+    return current_name;
+}
+
+std::size_t NbtCursor::depth() const
+{
+    return frames.size();
+}
+
+std::int32_t NbtCursor::remaining() const
+{
+    if (frames.empty() || frames.back().container != TagType::TagList)
+        throw std::runtime_error("cursor is not in a list");
+    return frames.back().remaining;
+}
+
+void NbtCursor::skip()
+{
+    if (!pending) return;
+    pending = false;
+    skip_tag(current, reader, endianness);
+}
+
+void NbtCursor::enter()
+{
+    if (!pending || (current != TagType::TagCompound && current != TagType::TagList))
+        throw std::runtime_error("cursor is not at an unread compound or list");
+    pending = false;
+
+    auto frame = Frame{current, TagType::TagEnd, 0, false};
+    if (current == TagType::TagList) {
+        if (endianness == Endianness::Big) read_list_header<Endianness::Big>(frame);
+        else read_list_header<Endianness::Little>(frame);
+    }
+    frames.push_back(frame);
+}
+
+void NbtCursor::exit()
+{
+    if (frames.empty()) throw std::runtime_error("cursor is not in a compound or list");
+    while (next()) {}
+    current = frames.back().container;
+    frames.pop_back();
+}
+
+std::int8_t NbtCursor::read_byte()
+{
+    return read_number_tag<std::int8_t, std::uint8_t>(TagType::TagByte);
+}
+
+std::int16_t NbtCursor::read_short()
+{
+    return read_number_tag<std::int16_t, std::uint16_t>(TagType::TagShort);
+}
+
+std::int32_t NbtCursor::read_int()
+{
+    return read_number_tag<std::int32_t, std::uint32_t>(TagType::TagInt);
+}
+
+std::int64_t NbtCursor::read_long()
+{
+    return read_number_tag<std::int64_t, std::uint64_t>(TagType::TagLong);
+}
+
+float NbtCursor::read_float()
+{
+    return read_number_tag<float, std::uint32_t>(TagType::TagFloat);
+}
+
+double NbtCursor::read_double()
+{
+    return read_number_tag<double, std::uint64_t>(TagType::TagDouble);
+}
+
+std::string NbtCursor::read_string()
+{
+    consume(TagType::TagString);
+    return endianness == Endianness::Big ? nbtpp2::read_string<Endianness::Big>(reader)
+                                         : nbtpp2::read_string<Endianness::Little>(reader);
+}
+
+std::vector<std::int8_t> NbtCursor::read_byte_array()
+{
+    return read_array_tag<std::int8_t, std::uint8_t>(TagType::TagByteArray);
+}
+
+std::vector<std::int32_t> NbtCursor::read_int_array()
+{
+    return read_array_tag<std::int32_t, std::uint32_t>(TagType::TagIntArray);
+}
+
+std::vector<std::int64_t> NbtCursor::read_long_array()
+{
+    return read_array_tag<std::int64_t, std::uint64_t>(TagType::TagLongArray);
+}
+
+Tag *NbtCursor::read_tag(const ReadOptions &options)
+{
+    consume(current);
+    return endianness == Endianness::Big ? nbtpp2::read_tag<Endianness::Big>(current, reader, options)
+                                         : nbtpp2::read_tag<Endianness::Little>(current, reader, options);
+}
+
+}
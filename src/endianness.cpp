@@ -4,10 +4,12 @@
 namespace nbtpp2
 {
 
+#if !defined(NBTPP2_SYSTEM_ENDIANNESS)
 const Endianness SYSTEM_ENDIANNESS = static_cast<Endianness>(
     ConvertToChars<std::uint16_t>{
         std::uint16_t{0x0001}
     }.chars[0]
 );
+#endif
 
 }
\ No newline at end of file
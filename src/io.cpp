@@ -1,5 +1,27 @@
 #include <nbtpp2/io.hpp>
-
+#include <nbtpp2/thread_pool.hpp>
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(NBTPP2_WITH_ZSTD)
+#   include <zstd.h>
+#endif
+
+#if defined(NBTPP2_WITH_LZ4)
+#   include <lz4frame.h>
+#endif
+
+#if defined(_WIN32)
+#   define WIN32_LEAN_AND_MEAN
+#   include <windows.h>
+#else
+#   include <fcntl.h>
+#   include <sys/mman.h>
+#   include <sys/stat.h>
+#   include <unistd.h>
+#endif
 
 namespace nbtpp2
 {
@@ -8,6 +30,16 @@ IstreamReader::IstreamReader(std::istream *istream)
     : istream(istream)
 {}
 
+void BinaryReader::skip(std::size_t n)
+{
+    char scratch[CHUNK];
+    while (n > 0) {
+        auto count = n < CHUNK ? n : CHUNK;
+        read(scratch, static_cast<std::uint32_t>(count));
+        n -= count;
+    }
+}
+
 void IstreamReader::read(char *buf, std::uint32_t n)
 {
     istream->read(buf, n);
@@ -31,6 +63,12 @@ void FileReader::read(char *buf, std::uint32_t n)
     std::fread(buf, sizeof(*buf), n, file);
 }
 
+void FileReader::skip(std::size_t n)
+{
+    if (n <= static_cast<std::size_t>(LONG_MAX) && std::fseek(file, static_cast<long>(n), SEEK_CUR) == 0) return;
+    BinaryReader::skip(n);
+}
+
 FileWriter::FileWriter(FILE *file)
     : file(file)
 {}
@@ -40,6 +78,188 @@ void FileWriter::write(const char *buf, std::uint32_t n)
     fwrite(buf, sizeof(*buf), n, file);
 }
 
+BufferReader::BufferReader(const char *data, std::size_t size)
+    : data(data), data_size(size)
+{}
+
+BufferReader::BufferReader(const std::vector<char> &buf)
+    : data(buf.data()), data_size(buf.size())
+{}
+
+void BufferReader::read(char *buf, std::uint32_t n)
+{
+    std::memcpy(buf, read_ptr(n), n);
+}
+
+void BufferReader::skip(std::size_t n)
+{
+    if (data_size - pos < n)
+        throw std::runtime_error("unexpected end of buffer");
+    pos += n;
+}
+
+const char *BufferReader::read_ptr(std::uint32_t n)
+{
+    if (data_size - pos < n)
+        throw std::runtime_error("unexpected end of buffer");
+    auto result = data + pos;
+    pos += n;
+    return result;
+}
+
+const char *BufferReader::buffer() const
+{
+    return data;
+}
+
+std::size_t BufferReader::position() const
+{
+    return pos;
+}
+
+std::size_t BufferReader::size() const
+{
+    return data_size;
+}
+
+SpanWriter::SpanWriter(char *data, std::size_t size)
+    : buf(data), buf_size(size)
+{}
+
+void SpanWriter::write(const char *data, std::uint32_t n)
+{
+    if (buf_size - pos < n)
+        throw std::runtime_error("write past the end of buffer");
+    std::memcpy(buf + pos, data, n);
+    pos += n;
+}
+
+std::size_t SpanWriter::position() const
+{
+    return pos;
+}
+
+void CountingWriter::write(const char *, std::uint32_t n)
+{
+    count += n;
+}
+
+std::size_t CountingWriter::size() const
+{
+    return count;
+}
+
+SharedBufferReader::SharedBufferReader(std::shared_ptr<const void> owner, const char *data, std::size_t size)
+    : BufferReader{data, size}, owner{std::move(owner)}
+{}
+
+const std::shared_ptr<const void> &SharedBufferReader::get_owner() const
+{
+    return owner;
+}
+
+BufferWriter::BufferWriter(std::size_t capacity)
+{
+    buf.reserve(capacity);
+}
+
+void BufferWriter::write(const char *data, std::uint32_t n)
+{
+    buf.insert(buf.end(), data, data + n);
+}
+
+const char *BufferWriter::data() const
+{
+    return buf.data();
+}
+
+std::size_t BufferWriter::size() const
+{
+    return buf.size();
+}
+
+std::vector<char> &BufferWriter::buffer()
+{
+    return buf;
+}
+
+void BufferWriter::clear()
+{
+    buf.clear();
+}
+
+#if defined(_WIN32)
+
+MmapReader::MmapReader(const std::string &path)
+{
+    file_handle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_handle == INVALID_HANDLE_VALUE)
+        throw std::runtime_error("could not open file");
+
+    LARGE_INTEGER file_size;
+    if (!GetFileSizeEx(file_handle, &file_size)) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("could not get file size");
+    }
+    data_size = static_cast<std::size_t>(file_size.QuadPart);
+    if (data_size == 0) return;
+
+    mapping_handle = CreateFileMappingA(file_handle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_handle == nullptr) {
+        CloseHandle(file_handle);
+        throw std::runtime_error("could not map file");
+    }
+    data = static_cast<const char *>(MapViewOfFile(mapping_handle, FILE_MAP_READ, 0, 0, 0));
+    if (data == nullptr) {
+        CloseHandle(mapping_handle);
+        CloseHandle(file_handle);
+        throw std::runtime_error("could not map file");
+    }
+}
+
+MmapReader::~MmapReader()
+{
+    if (data != nullptr) UnmapViewOfFile(data);
+    if (mapping_handle != nullptr) CloseHandle(mapping_handle);
+    CloseHandle(file_handle);
+}
+
+#else
+
+MmapReader::MmapReader(const std::string &path)
+{
+    auto fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        throw std::runtime_error("could not open file");
+
+    struct stat st{};
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        throw std::runtime_error("could not get file size");
+    }
+    data_size = static_cast<std::size_t>(st.st_size);
+    if (data_size == 0) {
+        close(fd);
+        return;
+    }
+
+    auto mapping = mmap(nullptr, data_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    // The mapping keeps its own reference to the file
+    close(fd);
+    if (mapping == MAP_FAILED)
+        throw std::runtime_error("could not map file");
+    madvise(mapping, data_size, MADV_SEQUENTIAL);
+    data = static_cast<const char *>(mapping);
+}
+
+MmapReader::~MmapReader()
+{
+    if (data != nullptr) munmap(const_cast<char *>(data), data_size);
+}
+
+#endif
+
 GzReader::GzReader(gzFile file)
     : file(file)
 {}
@@ -49,6 +269,12 @@ void GzReader::read(char *buf, std::uint32_t n)
     gzread(file, buf, n);
 }
 
+void GzReader::skip(std::size_t n)
+{
+    if (n <= static_cast<std::size_t>(LONG_MAX) && gzseek(file, static_cast<z_off_t>(n), SEEK_CUR) != -1) return;
+    BinaryReader::skip(n);
+}
+
 GzWriter::GzWriter(gzFile file)
     : file(file)
 {}
@@ -58,71 +284,65 @@ void GzWriter::write(const char *buf, std::uint32_t n)
     gzwrite(file, buf, n);
 }
 
-ZlibReader::ZlibReader(FILE *file)
+ZlibReader::ZlibReader(FILE *file, std::int32_t window_bits)
     : file(file)
 {
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
     stream.opaque = Z_NULL;
-    ret = inflateInit(&stream);
+    stream.next_in = in;
+    stream.avail_in = 0;
+    ret = inflateInit2(&stream, window_bits);
     if (ret != Z_OK)
-        throw std::runtime_error("Could not initialize deflate");
-
-    std::fseek(file, 0, SEEK_END);
-    file_size = static_cast<std::int64_t>(std::ftell(file));
-    std::rewind(file);
-
-    stream.next_in = buf;
+        throw std::runtime_error("Could not initialize inflate");
 }
 
-void ZlibReader::read_buf()
+std::size_t ZlibReader::inflate_into(std::uint8_t *dest, std::size_t n)
 {
-    std::size_t n_possible = CHUNK;
-    if (file_size - file_read < CHUNK)
-        n_possible = file_size - file_read;
-
-    if (buf_used < n_possible) {
-        std::size_t free = (CHUNK - buf_used);
-        std::size_t n_to_read = free > n_possible ? n_possible : free;
-        auto actually_read = std::fread(buf + buf_used, sizeof(char), n_to_read, file);
-        if (actually_read != n_to_read)
-            throw std::runtime_error("Could not read desired amount of bytes from file");
+    if (ret == Z_STREAM_END)
+        throw std::runtime_error("File is not big enough");
 
-        buf_used += actually_read;
-        file_read += actually_read;
-
-        stream.avail_in += actually_read;
+    if (stream.avail_in == 0) {
+        auto actually_read = std::fread(in, sizeof(char), CHUNK, file);
+        if (actually_read == 0)
+            throw std::runtime_error("File is not big enough");
+        stream.next_in = in;
+        stream.avail_in = static_cast<uInt>(actually_read);
     }
-}
 
-void ZlibReader::buffer_shift_back(std::size_t amount) {
-    while (amount-- > 0) {
-        for (std::size_t i = 0; i < buf_used && i < CHUNK; i++) {
-            buf[i] = buf[i+1];
-        }
-    }
+    stream.next_out = dest;
+    stream.avail_out = static_cast<uInt>(n);
+    ret = inflate(&stream, Z_NO_FLUSH);
+    if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+        throw std::runtime_error("Could not inflate file");
+
+    return n - stream.avail_out;
 }
 
 void ZlibReader::read(char *data, std::uint32_t n)
 {
-    std::size_t prior_total = stream.total_in;
-    std::size_t cur_read = 0;
-
-    while (cur_read < n) {
-        read_buf();
-
-        if (file_size - stream.total_in < n - cur_read)
-            throw std::runtime_error("File is not big enough");
-
-        stream.next_out = (unsigned char *) data;
-        stream.avail_out = n;
-        ret = inflate(&stream, Z_SYNC_FLUSH);
-        if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_NEED_DICT)
-            throw std::runtime_error("Could not inflate file");
+    auto dest = reinterpret_cast<std::uint8_t *>(data);
+
+    while (n > 0) {
+        if (out_pos == out_end) {
+            // Large reads bypass the output window to avoid copying twice
+            if (n >= CHUNK) {
+                auto produced = inflate_into(dest, n);
+                dest += produced;
+                n -= static_cast<std::uint32_t>(produced);
+                continue;
+            }
+            out_pos = 0;
+            out_end = inflate_into(out, CHUNK);
+            continue;
+        }
 
-        cur_read = stream.total_in - prior_total;
-        buffer_shift_back(cur_read);
-        stream.next_in = buf;
+        auto available = out_end - out_pos;
+        auto count = available < n ? available : n;
+        std::memcpy(dest, out + out_pos, count);
+        out_pos += count;
+        dest += count;
+        n -= static_cast<std::uint32_t>(count);
     }
 }
 
@@ -145,26 +365,71 @@ void ZlibWriter::write_internal(const char *buf, std::uint32_t n, bool flush)
 
         have = CHUNK - stream.avail_out;
         if (have == 0) continue;
-        if (fwrite(out, 1, have, dest) != have || ferror(dest)) {
-            deflateEnd(&stream);
-            throw std::runtime_error("Error writing to destination");
-        }
+        dest->write(reinterpret_cast<const char *>(out), have);
     }
     while (stream.avail_out == 0);
     if (stream.avail_in != 0) throw std::runtime_error("Error while trying to deflate");
 }
 
-ZlibWriter::ZlibWriter(FILE *dest, std::int32_t level)
-    : dest(dest)
+void validate_write_options(const WriteOptions &options)
+{
+    if (options.level != Z_DEFAULT_COMPRESSION && (options.level < 0 || options.level > 9))
+        throw std::runtime_error("deflate level must be between 0 and 9");
+    switch (options.strategy) {
+    case DeflateStrategy::Default:
+    case DeflateStrategy::Filtered:
+    case DeflateStrategy::Rle:
+    case DeflateStrategy::HuffmanOnly: break;
+    default: throw std::runtime_error("unknown deflate strategy");
+    }
+    if (options.window_bits < 9 || options.window_bits > 15)
+        throw std::runtime_error("deflate window bits must be between 9 and 15");
+    if (options.mem_level < 1 || options.mem_level > 9)
+        throw std::runtime_error("deflate memory level must be between 1 and 9");
+}
+
+void ZlibWriter::init(const WriteOptions &options, bool gzip)
 {
+    validate_write_options(options);
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
     stream.opaque = Z_NULL;
-    ret = deflateInit(&stream, level);
+    ret = deflateInit2(&stream, options.level, Z_DEFLATED, gzip ? options.window_bits + 16 : options.window_bits,
+                       options.mem_level, static_cast<int>(options.strategy));
     if (ret != Z_OK)
         throw std::runtime_error("Could not initialize deflate");
 }
 
+ZlibWriter::ZlibWriter(FILE *dest, std::int32_t level)
+    : file_writer(dest), dest(&file_writer)
+{
+    auto options = WriteOptions{};
+    options.level = level;
+    init(options, false);
+}
+
+ZlibWriter::ZlibWriter(BinaryWriter &dest, std::int32_t level, std::int32_t window_bits)
+    : dest(&dest)
+{
+    auto options = WriteOptions{};
+    options.level = level;
+    auto gzip = window_bits > MAX_WBITS;
+    options.window_bits = gzip ? window_bits - 16 : window_bits;
+    init(options, gzip);
+}
+
+ZlibWriter::ZlibWriter(FILE *dest, const WriteOptions &options, bool gzip)
+    : file_writer(dest), dest(&file_writer)
+{
+    init(options, gzip);
+}
+
+ZlibWriter::ZlibWriter(BinaryWriter &dest, const WriteOptions &options, bool gzip)
+    : dest(&dest)
+{
+    init(options, gzip);
+}
+
 void ZlibWriter::write(const char *buf, std::uint32_t n)
 {
     write_internal(buf, n, false);
@@ -176,4 +441,530 @@ ZlibWriter::~ZlibWriter()
     deflateEnd(&stream);
 }
 
+ParallelGzWriter::ParallelGzWriter(FILE *dest, const WriteOptions &options, unsigned threads, std::size_t block_size)
+    : file_writer(dest), dest(&file_writer), options(options), block_size(block_size),
+      pool(new ThreadPool{threads}), current(std::make_shared<std::vector<char>>()), crc(crc32(0, Z_NULL, 0))
+{
+    validate_write_options(options);
+    write_header();
+}
+
+ParallelGzWriter::ParallelGzWriter(BinaryWriter &dest, const WriteOptions &options, unsigned threads,
+                                   std::size_t block_size)
+    : dest(&dest), options(options), block_size(block_size),
+      pool(new ThreadPool{threads}), current(std::make_shared<std::vector<char>>()), crc(crc32(0, Z_NULL, 0))
+{
+    validate_write_options(options);
+    write_header();
+}
+
+void ParallelGzWriter::write_header()
+{
+    // Magic, deflate, no flags, no modification time, no extra flags, unknown OS
+    const char header[] = {0x1f, static_cast<char>(0x8b), 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, static_cast<char>(0xff)};
+    dest->write(header, sizeof(header));
+    current->reserve(block_size);
+}
+
+void ParallelGzWriter::submit_block(bool last)
+{
+    auto input = current;
+    auto dictionary = previous;
+    auto block_options = options;
+
+    pending.push_back(pool->submit([input, dictionary, block_options, last]()
+    {
+        auto block = Block{};
+        block.size = input->size();
+        block.crc = crc32(0, reinterpret_cast<const Bytef *>(input->data()), static_cast<uInt>(input->size()));
+
+        auto stream = z_stream{};
+        stream.zalloc = Z_NULL;
+        stream.zfree = Z_NULL;
+        stream.opaque = Z_NULL;
+        // Raw deflate, the gzip header and trailer are written by the ParallelGzWriter itself
+        if (deflateInit2(&stream, block_options.level, Z_DEFLATED, -block_options.window_bits, block_options.mem_level,
+                         static_cast<int>(block_options.strategy)) != Z_OK)
+            throw std::runtime_error("Could not initialize deflate");
+        // Ended however the block finishes, as growing the output can throw
+        struct StreamEnd
+        {
+            z_stream *stream;
+
+            ~StreamEnd()
+            {
+                deflateEnd(stream);
+            }
+        } stream_end{&stream};
+        // Prime with the end of the previous block so back-references across block boundaries still work
+        if (dictionary && !dictionary->empty()) {
+            auto window_size = std::size_t{1} << static_cast<unsigned>(block_options.window_bits);
+            auto dict_size = dictionary->size() < window_size ? dictionary->size() : window_size;
+            deflateSetDictionary(&stream, reinterpret_cast<const Bytef *>(dictionary->data() + dictionary->size() - dict_size),
+                                 static_cast<uInt>(dict_size));
+        }
+
+        // Non-final blocks end on a byte boundary (sync flush) so they can simply be concatenated
+        block.deflated.resize(deflateBound(&stream, static_cast<uLong>(input->size())) + 16);
+        stream.next_in = reinterpret_cast<Bytef *>(input->data());
+        stream.avail_in = static_cast<uInt>(input->size());
+        auto used = std::size_t{0};
+        while (true) {
+            stream.next_out = reinterpret_cast<Bytef *>(&block.deflated[used]);
+            stream.avail_out = static_cast<uInt>(block.deflated.size() - used);
+            auto ret = deflate(&stream, last ? Z_FINISH : Z_SYNC_FLUSH);
+            if (ret == Z_STREAM_ERROR)
+                throw std::runtime_error("Error while trying to deflate");
+            used = block.deflated.size() - stream.avail_out;
+            if (stream.avail_out != 0 && (!last || ret == Z_STREAM_END)) break;
+            block.deflated.resize(block.deflated.size() * 2);
+        }
+        block.deflated.resize(used);
+        return block;
+    }));
+
+    previous = current;
+    current = std::make_shared<std::vector<char>>();
+    current->reserve(block_size);
+
+    // Bound the amount of memory held by blocks waiting to be written
+    while (pending.size() > 2 * pool->size()) {
+        write_block();
+    }
+}
+
+void ParallelGzWriter::write_block()
+{
+    // Taken out first, so that a worker's error does not leave a used-up future behind
+    auto future = std::move(pending.front());
+    pending.pop_front();
+    auto block = future.get();
+    dest->write(block.deflated.data(), static_cast<std::uint32_t>(block.deflated.size()));
+    crc = crc32_combine(crc, block.crc, static_cast<z_off_t>(block.size));
+    total_size += static_cast<std::uint32_t>(block.size);
+}
+
+void ParallelGzWriter::write(const char *buf, std::uint32_t n)
+{
+    if (finished) throw std::runtime_error("write after the gzip stream was finished");
+    while (n > 0) {
+        auto count = block_size - current->size();
+        if (count > n) count = n;
+        current->insert(current->end(), buf, buf + count);
+        buf += count;
+        n -= static_cast<std::uint32_t>(count);
+        if (current->size() == block_size) submit_block(false);
+    }
+}
+
+void ParallelGzWriter::finish()
+{
+    if (finished) return;
+    finished = true;
+    submit_block(true);
+    while (!pending.empty()) {
+        write_block();
+    }
+
+    // CRC-32 and size modulo 2^32, both little-endian
+    char trailer[8];
+    for (std::size_t i = 0; i < 4; ++i) {
+        trailer[i] = static_cast<char>((crc >> (i * 8)) & 0xFF);
+        trailer[i + 4] = static_cast<char>((total_size >> (i * 8)) & 0xFF);
+    }
+    dest->write(trailer, sizeof(trailer));
+}
+
+ParallelGzWriter::~ParallelGzWriter()
+{
+    // The workers reference the blocks, so they must be done before the writer goes away; their errors are dropped
+    for (auto &block : pending) {
+        if (block.valid()) block.wait();
+    }
+}
+
+DecompressingReader::DecompressingReader(FILE *file)
+    : file(file)
+{}
+
+DecompressingReader::DecompressingReader(const char *data, std::size_t size)
+    : in_ptr(reinterpret_cast<const std::uint8_t *>(data)), in_avail(size)
+{}
+
+void DecompressingReader::read(char *data, std::uint32_t n)
+{
+    auto dest = reinterpret_cast<std::uint8_t *>(data);
+
+    while (n > 0) {
+        if (out_pos == out_end) {
+            if (in_avail == 0 && file != nullptr) {
+                in_avail = std::fread(in, sizeof(char), CHUNK, file);
+                in_ptr = in;
+            }
+            if (in_avail == 0)
+                throw std::runtime_error("Unexpected end of compressed data");
+            out_pos = 0;
+            out_end = decompress(out, CHUNK);
+            continue;
+        }
+
+        auto available = out_end - out_pos;
+        auto count = available < n ? available : n;
+        std::memcpy(dest, out + out_pos, count);
+        out_pos += count;
+        dest += count;
+        n -= static_cast<std::uint32_t>(count);
+    }
+}
+
+#if defined(NBTPP2_WITH_ZSTD)
+
+ZstdReader::ZstdReader(FILE *file)
+    : DecompressingReader(file)
+{
+    init();
+}
+
+ZstdReader::ZstdReader(const char *data, std::size_t size)
+    : DecompressingReader(data, size)
+{
+    init();
+}
+
+void ZstdReader::init()
+{
+    ctx = ZSTD_createDCtx();
+    if (ctx == nullptr)
+        throw std::runtime_error("Could not initialize Zstandard decompression");
+}
+
+std::size_t ZstdReader::decompress(std::uint8_t *dest, std::size_t n)
+{
+    auto input = ZSTD_inBuffer{in_ptr, in_avail, 0};
+    auto output = ZSTD_outBuffer{dest, n, 0};
+    auto ret = ZSTD_decompressStream(ctx, &output, &input);
+    if (ZSTD_isError(ret))
+        throw std::runtime_error(std::string("Could not decompress Zstandard data: ") + ZSTD_getErrorName(ret));
+    in_ptr += input.pos;
+    in_avail -= input.pos;
+    return output.pos;
+}
+
+ZstdReader::~ZstdReader()
+{
+    ZSTD_freeDCtx(ctx);
+}
+
+void ZstdWriter::require_support()
+{}
+
+ZstdWriter::ZstdWriter(FILE *dest, std::int32_t level)
+    : file_writer(dest), dest(&file_writer)
+{
+    init(level);
+}
+
+ZstdWriter::ZstdWriter(BinaryWriter &dest, std::int32_t level)
+    : dest(&dest)
+{
+    init(level);
+}
+
+void ZstdWriter::init(std::int32_t level)
+{
+    ctx = ZSTD_createCCtx();
+    if (ctx == nullptr)
+        throw std::runtime_error("Could not initialize Zstandard compression");
+    auto ret = ZSTD_CCtx_setParameter(ctx, ZSTD_c_compressionLevel, level);
+    if (ZSTD_isError(ret)) {
+        ZSTD_freeCCtx(ctx);
+        throw std::runtime_error(std::string("Could not set Zstandard compression level: ") + ZSTD_getErrorName(ret));
+    }
+}
+
+void ZstdWriter::write_internal(const char *buf, std::uint32_t n, bool flush)
+{
+    auto input = ZSTD_inBuffer{buf, n, 0};
+    auto remaining = std::size_t{0};
+    do {
+        auto output = ZSTD_outBuffer{out, CHUNK, 0};
+        remaining = ZSTD_compressStream2(ctx, &output, &input, flush ? ZSTD_e_end : ZSTD_e_continue);
+        if (ZSTD_isError(remaining))
+            throw std::runtime_error(std::string("Could not compress Zstandard data: ") + ZSTD_getErrorName(remaining));
+        if (output.pos > 0) dest->write(reinterpret_cast<const char *>(out), static_cast<std::uint32_t>(output.pos));
+    }
+    while (flush ? remaining != 0 : input.pos < input.size);
+}
+
+void ZstdWriter::write(const char *buf, std::uint32_t n)
+{
+    write_internal(buf, n, false);
+}
+
+ZstdWriter::~ZstdWriter()
+{
+    write_internal(nullptr, 0, true);
+    ZSTD_freeCCtx(ctx);
+}
+
+#else
+
+ZstdReader::ZstdReader(FILE *file)
+    : DecompressingReader(file)
+{
+    init();
+}
+
+ZstdReader::ZstdReader(const char *data, std::size_t size)
+    : DecompressingReader(data, size)
+{
+    init();
+}
+
+void ZstdReader::init()
+{
+    throw std::runtime_error("nbtpp2 was built without Zstandard support");
+}
+
+std::size_t ZstdReader::decompress(std::uint8_t *, std::size_t)
+{
+    return 0;
+}
+
+ZstdReader::~ZstdReader() = default;
+
+ZstdWriter::ZstdWriter(FILE *dest, std::int32_t level)
+    : file_writer(dest), dest(&file_writer)
+{
+    init(level);
+}
+
+ZstdWriter::ZstdWriter(BinaryWriter &dest, std::int32_t level)
+    : dest(&dest)
+{
+    init(level);
+}
+
+void ZstdWriter::init(std::int32_t)
+{
+    require_support();
+}
+
+void ZstdWriter::require_support()
+{
+    throw std::runtime_error("nbtpp2 was built without Zstandard support");
+}
+
+void ZstdWriter::write_internal(const char *, std::uint32_t, bool)
+{}
+
+void ZstdWriter::write(const char *, std::uint32_t)
+{}
+
+ZstdWriter::~ZstdWriter() = default;
+
+#endif
+
+#if defined(NBTPP2_WITH_LZ4)
+
+Lz4Reader::Lz4Reader(FILE *file)
+    : DecompressingReader(file)
+{
+    init();
+}
+
+Lz4Reader::Lz4Reader(const char *data, std::size_t size)
+    : DecompressingReader(data, size)
+{
+    init();
+}
+
+void Lz4Reader::init()
+{
+    auto ret = LZ4F_createDecompressionContext(&ctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret))
+        throw std::runtime_error(std::string("Could not initialize LZ4 decompression: ") + LZ4F_getErrorName(ret));
+}
+
+std::size_t Lz4Reader::decompress(std::uint8_t *dest, std::size_t n)
+{
+    auto consumed = in_avail;
+    auto produced = n;
+    auto ret = LZ4F_decompress(ctx, dest, &produced, in_ptr, &consumed, nullptr);
+    if (LZ4F_isError(ret))
+        throw std::runtime_error(std::string("Could not decompress LZ4 data: ") + LZ4F_getErrorName(ret));
+    in_ptr += consumed;
+    in_avail -= consumed;
+    return produced;
+}
+
+Lz4Reader::~Lz4Reader()
+{
+    LZ4F_freeDecompressionContext(ctx);
+}
+
+void Lz4Writer::require_support()
+{}
+
+Lz4Writer::Lz4Writer(FILE *dest, std::int32_t level)
+    : file_writer(dest), dest(&file_writer)
+{
+    init(level);
+}
+
+Lz4Writer::Lz4Writer(BinaryWriter &dest, std::int32_t level)
+    : dest(&dest)
+{
+    init(level);
+}
+
+void Lz4Writer::init(std::int32_t level)
+{
+    auto ret = LZ4F_createCompressionContext(&ctx, LZ4F_VERSION);
+    if (LZ4F_isError(ret))
+        throw std::runtime_error(std::string("Could not initialize LZ4 compression: ") + LZ4F_getErrorName(ret));
+
+    auto preferences = LZ4F_preferences_t{};
+    preferences.compressionLevel = level;
+    // compressUpdate needs room for a whole input block, compressEnd for whatever is still buffered
+    in.reserve(CHUNK);
+    out.resize(LZ4F_compressBound(CHUNK, &preferences) + LZ4F_HEADER_SIZE_MAX);
+
+    ret = LZ4F_compressBegin(ctx, out.data(), out.size(), &preferences);
+    if (LZ4F_isError(ret)) {
+        LZ4F_freeCompressionContext(ctx);
+        throw std::runtime_error(std::string("Could not start LZ4 frame: ") + LZ4F_getErrorName(ret));
+    }
+    dest->write(out.data(), static_cast<std::uint32_t>(ret));
+}
+
+void Lz4Writer::flush_input()
+{
+    auto ret = LZ4F_compressUpdate(ctx, out.data(), out.size(), in.data(), in.size(), nullptr);
+    if (LZ4F_isError(ret))
+        throw std::runtime_error(std::string("Could not compress LZ4 data: ") + LZ4F_getErrorName(ret));
+    if (ret > 0) dest->write(out.data(), static_cast<std::uint32_t>(ret));
+    in.clear();
+}
+
+void Lz4Writer::write(const char *buf, std::uint32_t n)
+{
+    while (n > 0) {
+        auto count = CHUNK - in.size();
+        if (count > n) count = n;
+        in.insert(in.end(), buf, buf + count);
+        buf += count;
+        n -= static_cast<std::uint32_t>(count);
+        if (in.size() == CHUNK) flush_input();
+    }
+}
+
+Lz4Writer::~Lz4Writer()
+{
+    if (!in.empty()) flush_input();
+    auto ret = LZ4F_compressEnd(ctx, out.data(), out.size(), nullptr);
+    if (!LZ4F_isError(ret) && ret > 0) dest->write(out.data(), static_cast<std::uint32_t>(ret));
+    LZ4F_freeCompressionContext(ctx);
+}
+
+#else
+
+Lz4Reader::Lz4Reader(FILE *file)
+    : DecompressingReader(file)
+{
+    init();
+}
+
+Lz4Reader::Lz4Reader(const char *data, std::size_t size)
+    : DecompressingReader(data, size)
+{
+    init();
+}
+
+void Lz4Reader::init()
+{
+    throw std::runtime_error("nbtpp2 was built without LZ4 support");
+}
+
+std::size_t Lz4Reader::decompress(std::uint8_t *, std::size_t)
+{
+    return 0;
+}
+
+Lz4Reader::~Lz4Reader() = default;
+
+Lz4Writer::Lz4Writer(FILE *dest, std::int32_t level)
+    : file_writer(dest), dest(&file_writer)
+{
+    init(level);
+}
+
+Lz4Writer::Lz4Writer(BinaryWriter &dest, std::int32_t level)
+    : dest(&dest)
+{
+    init(level);
+}
+
+void Lz4Writer::init(std::int32_t)
+{
+    require_support();
+}
+
+void Lz4Writer::require_support()
+{
+    throw std::runtime_error("nbtpp2 was built without LZ4 support");
+}
+
+void Lz4Writer::flush_input()
+{}
+
+void Lz4Writer::write(const char *, std::uint32_t)
+{}
+
+Lz4Writer::~Lz4Writer() = default;
+
+#endif
+
+void inflate_buffer(const char *data, std::size_t size, std::vector<char> &out)
+{
+    auto stream = z_stream{};
+    stream.zalloc = Z_NULL;
+    stream.zfree = Z_NULL;
+    stream.opaque = Z_NULL;
+    // 32 enables automatic zlib/gzip header detection
+    if (inflateInit2(&stream, MAX_WBITS + 32) != Z_OK)
+        throw std::runtime_error("Could not initialize inflate");
+
+    // Guess the inflated size, unless a gzip trailer tells us (ISIZE is the inflated size modulo 2^32)
+    auto expected_size = size * 4;
+    if (size >= 18 && static_cast<std::uint8_t>(data[0]) == 0x1f && static_cast<std::uint8_t>(data[1]) == 0x8b) {
+        auto trailer = reinterpret_cast<const std::uint8_t *>(data + size - 4);
+        auto isize = static_cast<std::size_t>(trailer[0]) | static_cast<std::size_t>(trailer[1]) << 8u
+            | static_cast<std::size_t>(trailer[2]) << 16u | static_cast<std::size_t>(trailer[3]) << 24u;
+        // Deflate cannot compress better than about 1032:1, anything above that is not a real size
+        if (isize / 1032 <= size) expected_size = isize;
+    }
+
+    out.clear();
+    if (out.capacity() < expected_size) out.reserve(expected_size);
+    stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data));
+    stream.avail_in = static_cast<uInt>(size);
+
+    auto ret = Z_OK;
+    while (ret != Z_STREAM_END) {
+        if (out.size() == out.capacity()) out.reserve(out.capacity() * 2 + CHUNK);
+        auto used = out.size();
+        out.resize(out.capacity());
+        stream.next_out = reinterpret_cast<Bytef *>(&out[used]);
+        stream.avail_out = static_cast<uInt>(out.size() - used);
+        ret = inflate(&stream, Z_NO_FLUSH);
+        out.resize(out.size() - stream.avail_out);
+        if (ret != Z_OK && ret != Z_STREAM_END) {
+            inflateEnd(&stream);
+            throw std::runtime_error(ret == Z_BUF_ERROR ? "Unexpected end of compressed data" : "Could not inflate data");
+        }
+    }
+    inflateEnd(&stream);
+}
+
 }
@@ -0,0 +1,109 @@
+#include <nbtpp2/key.hpp>
+
+#include <deque>
+#include <mutex>
+#include <unordered_map>
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+/// Number of independently locked parts of the key pool
+const std::size_t KEY_SHARDS = 16;
+
+/// Number of recently used keys cached per thread
+const std::size_t KEY_CACHE_SIZE = 256;
+
+struct KeyShard
+{
+    std::mutex mutex;
+    std::unordered_multimap<std::uint32_t, const Key::Record *> records;
+    std::deque<Key::Record> storage;
+    std::size_t bytes = 0;
+};
+
+KeyShard *key_shards()
+{
+    static KeyShard shards[KEY_SHARDS];
+    return shards;
+}
+
+/// Direct-mapped cache of interned names, so repeated names do not take a shard lock
+thread_local const Key::Record *key_cache[KEY_CACHE_SIZE] = {nullptr};
+
+bool record_equals(const Key::Record *record, std::uint32_t hash, const char *data, std::size_t size)
+{
+    return record->hash == hash && record->text.size() == size && std::memcmp(record->text.data(), data, size) == 0;
+}
+
+const Key::Record *intern(const char *data, std::size_t size)
+{
+    auto hash = key_hash(data, size);
+    auto &cached = key_cache[hash % KEY_CACHE_SIZE];
+    if (cached != nullptr && record_equals(cached, hash, data, size)) return cached;
+
+    auto &shard = key_shards()[(hash >> 24u) % KEY_SHARDS];
+    std::lock_guard<std::mutex> lock{shard.mutex};
+    auto range = shard.records.equal_range(hash);
+    for (auto it = range.first; it != range.second; ++it) {
+        if (record_equals(it->second, hash, data, size)) return cached = it->second;
+    }
+    shard.storage.push_back(Key::Record{std::string(data, size), hash});
+    shard.bytes += size;
+    shard.records.emplace(hash, &shard.storage.back());
+    return cached = &shard.storage.back();
+}
+
+}
+
+std::uint32_t key_hash(const char *data, std::size_t size)
+{
+    std::uint32_t hash = 2166136261u;
+    for (std::size_t i = 0; i < size; ++i) {
+        hash ^= static_cast<std::uint8_t>(data[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+Key::Key()
+    : record{intern("", 0)}
+{}
+
+Key::Key(const std::string &text)
+    : record{intern(text.data(), text.size())}
+{}
+
+Key::Key(const char *text)
+    : record{intern(text, std::strlen(text))}
+{}
+
+Key::Key(const char *data, std::size_t size)
+    : record{intern(data, size)}
+{}
+
+std::size_t interned_key_count()
+{
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < KEY_SHARDS; ++i) {
+        auto &shard = key_shards()[i];
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        count += shard.storage.size();
+    }
+    return count;
+}
+
+std::size_t interned_key_bytes()
+{
+    std::size_t bytes = 0;
+    for (std::size_t i = 0; i < KEY_SHARDS; ++i) {
+        auto &shard = key_shards()[i];
+        std::lock_guard<std::mutex> lock{shard.mutex};
+        bytes += shard.bytes;
+    }
+    return bytes;
+}
+
+}
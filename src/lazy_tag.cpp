@@ -0,0 +1,53 @@
+#include <nbtpp2/lazy_tag.hpp>
+#include <nbtpp2/util.hpp>
+
+namespace nbtpp2
+{
+
+LazyTag::LazyTag(TagType type, std::shared_ptr<const void> owner, const char *data, std::size_t size,
+                 Endianness endianness, const ReadOptions &options)
+    : Tag{type, true}, owner{std::move(owner)}, data{data}, size{size}, endianness{endianness}, options(options)
+{}
+
+void LazyTag::write(BinaryWriter &writer, Endianness endianness)
+{
+    if (endianness == this->endianness) {
+        write_bytes(writer, data, size);
+        return;
+    }
+    std::unique_ptr<Tag> tag{materialize()};
+    tag->write(writer, endianness);
+}
+
+std::size_t LazyTag::serialized_size() const
+{
+    return size;
+}
+
+Tag *LazyTag::materialize() const
+{
+    SharedBufferReader reader{owner, data, size};
+    return read_tag(identify(), reader, endianness, options);
+}
+
+Tag *LazyTag::read(TagType type, BinaryReader &reader, Endianness endianness, const ReadOptions &options)
+{
+    auto source = dynamic_cast<SharedBufferReader *>(&reader);
+    switch (type) {
+    case TagType::TagByteArray:
+    case TagType::TagIntArray:
+    case TagType::TagLongArray:
+    case TagType::TagList:
+    case TagType::TagCompound:
+        if (source != nullptr) break;
+        return read_tag(type, reader, endianness, options);
+    default:
+        return read_tag(type, reader, endianness, options);
+    }
+
+    auto start = source->position();
+    skip_tag(type, *source, endianness);
+    return new LazyTag{type, source->get_owner(), source->buffer() + start, source->position() - start, endianness, options};
+}
+
+}
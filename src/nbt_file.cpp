@@ -21,24 +21,154 @@ void NbtFile::read(BinaryReader &reader, Endianness endianness)
 {
     auto tag_id = read_tag_id(reader);
     root_name = read_string(reader, endianness);
-    root.reset(read_tag(tag_id, reader, endianness));
+    root.reset(read_tag(tag_id, reader, endianness, read_options));
 }
 
-void NbtFile::read_gzip(const std::string &path, Endianness endianness)
+void NbtFile::keep_arena(std::shared_ptr<Arena> arena)
 {
-    write_compression = Compression::Gzip;
-    auto file = gzopen(path.c_str(), "rb");
-    auto reader = GzReader{file};
-    read(reader, endianness);
-    gzclose(file);
+    if (!arena || !root) return;
+    // Members are destroyed in reverse order, so the tree goes before the arena it lives in
+    struct Owner
+    {
+        std::shared_ptr<Arena> arena;
+        std::shared_ptr<Tag> root;
+    };
+    auto owner = std::make_shared<Owner>(Owner{std::move(arena), std::move(root)});
+    root = std::shared_ptr<Tag>{owner, owner->root.get()};
 }
 
-void NbtFile::read_zlib(const std::string &path, Endianness endianness)
+template<typename F>
+NbtFile::Compression NbtFile::with_reader(const std::string &path, Compression compression, F f)
 {
+    if (compression == Compression::Detect) {
+        std::ifstream stream{path, std::ios_base::binary};
+        if (!stream) throw std::runtime_error("could not open file");
+        char magic[4];
+        stream.read(magic, sizeof(magic));
+        compression = detect_compression(magic, static_cast<std::size_t>(stream.gcount()));
+    }
+
+    if (compression == Compression::Gzip) {
+        auto file = gzopen(path.c_str(), "rb");
+        if (file == nullptr) throw std::runtime_error("could not open file");
+        try {
+            auto reader = GzReader{file};
+            f(static_cast<BinaryReader &>(reader));
+        }
+        catch (...) {
+            gzclose(file);
+            throw;
+        }
+        gzclose(file);
+        return compression;
+    }
+
+    if (compression == Compression::None) {
+        MmapReader reader{path};
+        f(static_cast<BinaryReader &>(reader));
+        return compression;
+    }
+
     auto file = fopen(path.c_str(), "rb");
-    auto reader = ZlibReader{file};
-    read(reader, endianness);
+    if (file == nullptr) throw std::runtime_error("could not open file");
+    try {
+        switch (compression) {
+        case Compression::Zstd: {
+            ZstdReader reader{file};
+            f(static_cast<BinaryReader &>(reader));
+            break;
+        }
+        case Compression::Lz4: {
+            Lz4Reader reader{file};
+            f(static_cast<BinaryReader &>(reader));
+            break;
+        }
+        default: {
+            ZlibReader reader{file};
+            f(static_cast<BinaryReader &>(reader));
+        }
+        }
+    }
+    catch (...) {
+        fclose(file);
+        throw;
+    }
     fclose(file);
+    return compression;
+}
+
+NbtFile::Compression NbtFile::detect_compression(const char *magic, std::size_t size)
+{
+    auto bytes = reinterpret_cast<const std::uint8_t *>(magic);
+    if (size >= 4 && bytes[0] == 0x28 && bytes[1] == 0xb5 && bytes[2] == 0x2f && bytes[3] == 0xfd)
+        return Compression::Zstd;
+    if (size >= 4 && bytes[0] == 0x04 && bytes[1] == 0x22 && bytes[2] == 0x4d && bytes[3] == 0x18)
+        return Compression::Lz4;
+    if (size >= 1 && bytes[0] == 0x1f) return Compression::Gzip;
+    // zlib header: deflate method, window of at most 32 KiB and a check value making the first two bytes a multiple of 31
+    if (size >= 2 && (bytes[0] & 0x0fu) == 8 && (bytes[0] >> 4u) <= 7 && ((bytes[0] << 8u) | bytes[1]) % 31 == 0)
+        return Compression::Zlib;
+    return Compression::None;
+}
+
+void NbtFile::read_buffer(const char *data, std::size_t size, Endianness endianness, Compression compression)
+{
+    if (compression == Compression::Detect) compression = detect_compression(data, size);
+    write_compression = compression;
+
+    switch (compression) {
+    case Compression::Zstd: {
+        ZstdReader reader{data, size};
+        read(reader, endianness);
+        return;
+    }
+    case Compression::Lz4: {
+        Lz4Reader reader{data, size};
+        read(reader, endianness);
+        return;
+    }
+    case Compression::Gzip:
+    case Compression::Zlib: {
+        auto inflated = std::vector<char>{};
+        inflate_buffer(data, size, inflated);
+        auto reader = BufferReader{inflated};
+        read(reader, endianness);
+        return;
+    }
+    default:
+        auto reader = BufferReader{data, size};
+        read(reader, endianness);
+    }
+}
+
+void NbtFile::read_shared(std::shared_ptr<const void> owner, const char *data, std::size_t size,
+                          Endianness endianness, Compression compression)
+{
+    if (compression == Compression::Detect) compression = detect_compression(data, size);
+
+    switch (compression) {
+    case Compression::Gzip:
+    case Compression::Zlib: {
+        write_compression = compression;
+        auto inflated = std::make_shared<std::vector<char>>();
+        inflate_buffer(data, size, *inflated);
+        SharedBufferReader reader{inflated, inflated->data(), inflated->size()};
+        read(reader, endianness);
+        return;
+    }
+    case Compression::None: {
+        write_compression = compression;
+        if (owner == nullptr) {
+            auto copy = std::make_shared<std::vector<char>>(data, data + size);
+            data = copy->data();
+            owner = std::move(copy);
+        }
+        SharedBufferReader reader{std::move(owner), data, size};
+        read(reader, endianness);
+        return;
+    }
+    default: read_buffer(data, size, endianness, compression);
+    }
 }
 
 void NbtFile::write(BinaryWriter &writer, Endianness endianness)
@@ -48,75 +178,179 @@ void NbtFile::write(BinaryWriter &writer, Endianness endianness)
     root->write(writer, endianness);
 }
 
-void NbtFile::write_gzip(const std::string &path, Endianness endianness)
+std::size_t NbtFile::serialized_size() const
 {
-    auto file = gzopen(path.c_str(), "wb");
-    auto writer = GzWriter{file};
+    return 1 + sizeof(std::uint16_t) + static_cast<std::uint16_t>(root_name.size()) + root->serialized_size();
+}
+
+std::vector<char> NbtFile::serialize(Endianness endianness)
+{
+    auto buffer = std::vector<char>(serialized_size());
+    serialize(buffer.data(), buffer.size(), endianness);
+    return buffer;
+}
+
+std::size_t NbtFile::serialize(char *data, std::size_t size, Endianness endianness)
+{
+    SpanWriter writer{data, size};
     write(writer, endianness);
-    gzclose(file);
+    return writer.position();
 }
 
-void NbtFile::write_zlib(const std::string &path, Endianness endianness)
+void NbtFile::write_gzip(const std::string &path, Endianness endianness, const WriteOptions &options)
 {
     auto file = fopen(path.c_str(), "wb");
-    {
-        auto writer = ZlibWriter{file, DEFLATE_LEVEL};
+    if (file == nullptr) throw std::runtime_error("could not open file");
+    try {
+        if (write_threads != 1) {
+            ParallelGzWriter writer{file, options, write_threads};
+            write(writer, endianness);
+            writer.finish();
+        }
+        else {
+            ZlibWriter writer{file, options, true};
+            write(writer, endianness);
+        }
+    }
+    catch (...) {
+        fclose(file);
+        throw;
+    }
+    fclose(file);
+}
+
+void NbtFile::write_zlib(const std::string &path, Endianness endianness, const WriteOptions &options)
+{
+    auto file = fopen(path.c_str(), "wb");
+    if (file == nullptr) throw std::runtime_error("could not open file");
+    try {
+        ZlibWriter writer{file, options};
         write(writer, endianness);
     }
+    catch (...) {
+        fclose(file);
+        throw;
+    }
     fclose(file);
 }
 
-void NbtFile::write(const std::string &path, Endianness endianness, Compression compression)
+template<typename WriterT>
+void NbtFile::write_compressed(const std::string &path, Endianness endianness)
 {
+    WriterT::require_support();
+    auto file = fopen(path.c_str(), "wb");
+    if (file == nullptr) throw std::runtime_error("could not open file");
+    try {
+        WriterT writer{file};
+        write(writer, endianness);
+    }
+    catch (...) {
+        fclose(file);
+        throw;
+    }
+    fclose(file);
+}
+
+void NbtFile::write(const std::string &path, Endianness endianness, Compression compression,
+                    const WriteOptions &options)
+{
+    if (compression == Compression::Detect) compression = write_compression;
+
     switch (compression) {
-    case Compression::Detect:
-        switch (write_compression) {
-        case Compression::Gzip: write_gzip(path, endianness);
-            break;
-        case Compression::Zlib: write_zlib(path, endianness);
-            break;
-        default:;
-        }
+    case Compression::Gzip: write_gzip(path, endianness, options);
+        break;
+    case Compression::Zlib: write_zlib(path, endianness, options);
         break;
-    case Compression::Gzip: write_gzip(path, endianness);
+    case Compression::Zstd: write_compressed<ZstdWriter>(path, endianness);
         break;
-    case Compression::Zlib: write_zlib(path, endianness);
+    case Compression::Lz4: write_compressed<Lz4Writer>(path, endianness);
         break;
     default: auto file = fopen(path.c_str(), "wb");
+        if (file == nullptr) throw std::runtime_error("could not open file");
         auto writer = FileWriter{file};
         write(writer, endianness);
         fclose(file);
     }
 }
 
-NbtFile::NbtFile(const std::string &path, nbtpp2::Endianness endianness, Compression compression)
+void NbtFile::write(BufferWriter &writer, Endianness endianness, Compression compression, const WriteOptions &options)
 {
-    std::ifstream stream{path, std::ios_base::binary};
-    if (!stream) throw std::runtime_error("could not open file");
-    int first_byte = stream.peek();
-    stream.close();
+    if (compression == Compression::Detect) compression = write_compression;
 
     switch (compression) {
-    case Compression::Gzip: read_gzip(path, endianness);
-        return;
-    case Compression::Zlib: read_zlib(path, endianness);
-        return;
-    case Compression::Detect:
-        switch (first_byte) {
-        case 0x1f: read_gzip(path, endianness);
-            return;
-        case 0x78: read_zlib(path, endianness);
-            return;
-        default:;
+    case Compression::Gzip: {
+        if (write_threads != 1) {
+            ParallelGzWriter deflater{writer, options, write_threads};
+            write(deflater, endianness);
+            deflater.finish();
+            break;
         }
+        ZlibWriter deflater{writer, options, true};
+        write(deflater, endianness);
+        break;
+    }
+    case Compression::Zlib: {
+        ZlibWriter deflater{writer, options};
+        write(deflater, endianness);
+        break;
+    }
+    case Compression::Zstd: {
+        ZstdWriter compressor{writer};
+        write(compressor, endianness);
+        break;
+    }
+    case Compression::Lz4: {
+        Lz4Writer compressor{writer};
+        write(compressor, endianness);
+        break;
+    }
     default:
-        auto file = fopen(path.c_str(), "rb");
-        auto reader = FileReader{file};
-        read(reader, endianness);
-        fclose(file);
+        writer.buffer().reserve(writer.size() + serialized_size());
+        write(static_cast<BinaryWriter &>(writer), endianness);
     }
 }
 
+NbtFile::NbtFile(const std::string &path, nbtpp2::Endianness endianness, Compression compression,
+                 const ReadOptions &options)
+    : read_options{options}
+{
+    auto arena = options.arena ? std::make_shared<Arena>() : nullptr;
+    {
+        ArenaScope scope{arena ? arena.get() : Arena::current()};
+        if (options.lazy) {
+            auto file = std::make_shared<MmapReader>(path);
+            read_shared(file, file->buffer(), file->size(), endianness, compression);
+        }
+        else if (options.in_memory) {
+            MmapReader file{path};
+            read_buffer(file.buffer(), file.size(), endianness, compression);
+        }
+        else {
+            write_compression = with_reader(path, compression, [&](BinaryReader &reader) { read(reader, endianness); });
+        }
+    }
+    keep_arena(std::move(arena));
+}
+
+void NbtFile::visit(const std::string &path, nbtpp2::Endianness endianness, NbtVisitor &visitor,
+                    Compression compression)
+{
+    with_reader(path, compression, [&](BinaryReader &reader) { nbtpp2::visit(reader, endianness, visitor); });
+}
+
+NbtFile::NbtFile(const char *data, std::size_t size, nbtpp2::Endianness endianness, Compression compression,
+                 const ReadOptions &options)
+    : read_options{options}
+{
+    auto arena = options.arena ? std::make_shared<Arena>() : nullptr;
+    {
+        ArenaScope scope{arena ? arena.get() : Arena::current()};
+        if (options.lazy) read_shared(nullptr, data, size, endianness, compression);
+        else read_buffer(data, size, endianness, compression);
+    }
+    keep_arena(std::move(arena));
+}
+
 NbtFile::NbtFile(std::shared_ptr<tags::TagCompound> root, std::string root_name)
     : root{std::move(root)}, root_name{std::move(root_name)}
 {}
@@ -125,7 +359,7 @@ NbtFile::NbtFile(std::string root_name)
     : root{std::make_shared<tags::TagCompound>(tags::TagCompound({}))}, root_name{std::move(root_name)}
 {}
 
-std::map<std::string, Tag *> &NbtFile::get_root_tag_compound()
+CompoundMap &NbtFile::get_root_tag_compound()
 { return root->as<tags::TagCompound>().value; }
 
 Tag &NbtFile::get_root_tag()
@@ -138,4 +372,9 @@ bool NbtFile::set_write_compression(Compression compression)
     return true;
 }
 
+void NbtFile::set_write_threads(unsigned threads)
+{
+    write_threads = threads;
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,194 @@
+#include <nbtpp2/patch.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+/// Step of a path: a compound entry, followed by the indices of the list elements selected in it
+struct PathStep
+{
+    std::string name;
+    std::vector<std::int32_t> indices;
+};
+
+std::vector<PathStep> parse_path(const std::string &path)
+{
+    auto steps = std::vector<PathStep>{};
+    std::size_t start = 0;
+    while (true) {
+        auto end = path.find('.', start);
+        if (end == std::string::npos) end = path.size();
+        auto part = path.substr(start, end - start);
+
+        auto step = PathStep{};
+        auto bracket = part.find('[');
+        step.name = part.substr(0, bracket);
+        while (bracket != std::string::npos) {
+            auto close = part.find(']', bracket);
+            if (close == std::string::npos || close == bracket + 1)
+                throw std::runtime_error("malformed index in path " + path);
+            auto digits = part.substr(bracket + 1, close - bracket - 1);
+            if (digits.find_first_not_of("0123456789") != std::string::npos || digits.size() > 9)
+                throw std::runtime_error("malformed index in path " + path);
+            step.indices.push_back(static_cast<std::int32_t>(std::stoi(digits)));
+            bracket = close + 1 == part.size() ? std::string::npos : close + 1;
+            if (bracket != std::string::npos && part[bracket] != '[')
+                throw std::runtime_error("malformed index in path " + path);
+        }
+        if (step.name.empty()) throw std::runtime_error("empty name in path " + path);
+        steps.push_back(std::move(step));
+
+        if (end == path.size()) return steps;
+        start = end + 1;
+    }
+}
+
+/// Counts the bytes read and skipped through another BinaryReader
+class CountingReader final: public BinaryReader
+{
+    BinaryReader &reader;
+    std::size_t count = 0;
+
+public:
+    explicit CountingReader(BinaryReader &reader)
+        : reader(reader)
+    {}
+
+    void read(char *buf, std::uint32_t n) override
+    {
+        reader.read(buf, n);
+        count += n;
+    }
+
+    void skip(std::size_t n) override
+    {
+        reader.skip(n);
+        count += n;
+    }
+
+    std::size_t position() const
+    {
+        return count;
+    }
+};
+
+template<Endianness E>
+ValueLocation locate(BinaryReader &inner, const std::string &path)
+{
+    auto steps = parse_path(path);
+    CountingReader reader{inner};
+
+    auto type = read_tag_id(reader);
+    if (type != TagType::TagCompound) throw std::runtime_error("root tag is not a TAG_Compound");
+    reader.skip(read_number<E, std::uint16_t, std::uint16_t>(reader));
+
+    auto name = std::string{};
+    for (const auto &step : steps) {
+        if (type != TagType::TagCompound)
+            throw std::runtime_error("expected a TAG_Compound before " + step.name + " in path " + path);
+
+        // Compare names by length first, so that most entries are passed over without reading their name
+        while (true) {
+            type = read_tag_id(reader);
+            if (type == TagType::TagEnd) throw std::runtime_error("no tag at path " + path);
+            auto len = read_number<E, std::uint16_t, std::uint16_t>(reader);
+            if (len == step.name.size()) {
+                name.resize(len);
+                reader.read(&name[0], len);
+                if (name == step.name) break;
+            }
+            else {
+                reader.skip(len);
+            }
+            skip_tag(type, reader, E);
+        }
+
+        for (auto index : step.indices) {
+            if (type != TagType::TagList) throw std::runtime_error("expected a TAG_List at " + step.name + " in path " + path);
+            type = read_tag_id(reader);
+            auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+            if (index >= len) throw std::runtime_error("no tag at path " + path);
+            for (std::int32_t i = 0; i < index; ++i) {
+                skip_tag(type, reader, E);
+            }
+        }
+    }
+    return ValueLocation{type, reader.position()};
+}
+
+void check_type(const ValueLocation &location, TagType type, const std::string &path)
+{
+    if (location.type != type)
+        throw std::runtime_error("expected " + tag_type_to_string(type) + " at path " + path + ", got "
+                                 + tag_type_to_string(location.type));
+}
+
+}
+
+ValueLocation locate_value(BinaryReader &reader, Endianness endianness, const std::string &path)
+{
+    return endianness == Endianness::Big ? locate<Endianness::Big>(reader, path)
+                                         : locate<Endianness::Little>(reader, path);
+}
+
+ValueLocation locate_value(const char *data, std::size_t size, Endianness endianness, const std::string &path)
+{
+    BufferReader reader{data, size};
+    return locate_value(reader, endianness, path);
+}
+
+namespace detail
+{
+
+void patch_bytes(char *data, std::size_t size, Endianness endianness, const std::string &path, TagType type,
+                 const char *bytes, std::size_t count)
+{
+    auto location = locate_value(data, size, endianness, path);
+    check_type(location, type, path);
+    if (location.offset > size || count > size - location.offset)
+        throw std::runtime_error("read past the end of buffer");
+    std::memcpy(data + location.offset, bytes, count);
+}
+
+void patch_file_bytes(const std::string &file, Endianness endianness, const std::string &path, TagType type,
+                      const char *bytes, std::size_t count)
+{
+    auto handle = fopen(file.c_str(), "r+b");
+    if (handle == nullptr) throw std::runtime_error("could not open file");
+    try {
+        if (std::fseek(handle, 0, SEEK_END) != 0) throw std::runtime_error("could not seek in file");
+        auto file_size = std::ftell(handle);
+        if (file_size < 0) throw std::runtime_error("could not seek in file");
+        std::rewind(handle);
+
+        // A compressed file does not start with the id of a TAG_Compound, so it is rejected by locate_value()
+        FileReader reader{handle};
+        auto location = locate_value(reader, endianness, path);
+        check_type(location, type, path);
+        // Short reads and seeks past the end go unnoticed while locating, so a truncated file can yield any offset
+        if (location.offset > static_cast<std::size_t>(file_size)
+            || count > static_cast<std::size_t>(file_size) - location.offset)
+            throw std::runtime_error("tag at path " + path + " lies past the end of the file");
+
+        // Switching from reading to writing requires a seek
+        if (fseek(handle, static_cast<long>(location.offset), SEEK_SET) != 0
+            || fwrite(bytes, 1, count, handle) != count || fflush(handle) != 0)
+            throw std::runtime_error("could not write to file");
+    }
+    catch (...) {
+        fclose(handle);
+        throw;
+    }
+    fclose(handle);
+}
+
+}
+
+}
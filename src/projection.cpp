@@ -0,0 +1,72 @@
+#include <nbtpp2/projection.hpp>
+
+#include <stdexcept>
+
+namespace nbtpp2
+{
+
+Projection::Projection(const std::vector<std::string> &paths)
+{
+    for (const auto &path : paths) {
+        add(path);
+    }
+}
+
+Projection &Projection::child(const Key &name, bool elements)
+{
+    for (auto &node : children) {
+        if (node.elements == elements && node.name == name) return node;
+    }
+    children.emplace_back();
+    children.back().name = name;
+    children.back().elements = elements;
+    return children.back();
+}
+
+void Projection::add(const std::string &path)
+{
+    auto node = this;
+    std::size_t start = 0;
+    while (true) {
+        auto end = path.find('.', start);
+        if (end == std::string::npos) end = path.size();
+
+        // A part is a name followed by any number of [*]
+        auto name_end = path.find('[', start);
+        if (name_end == std::string::npos || name_end > end) name_end = end;
+        if (name_end == start && name_end == end) throw std::runtime_error("empty part in path " + path);
+        if (name_end > start) node = &node->child(Key{path.data() + start, name_end - start}, false);
+        for (auto i = name_end; i < end; i += 3) {
+            if (path.compare(i, 3, "[*]") != 0 || i + 3 > end)
+                throw std::runtime_error("expected [*] after a name in path " + path);
+            node = &node->child(Key{}, true);
+        }
+
+        if (end == path.size()) break;
+        start = end + 1;
+    }
+    node->whole = true;
+}
+
+bool Projection::selects_all() const
+{
+    return whole;
+}
+
+const Projection *Projection::field(const Key &name) const
+{
+    for (const auto &node : children) {
+        if (!node.elements && node.name == name) return &node;
+    }
+    return nullptr;
+}
+
+const Projection *Projection::element() const
+{
+    for (const auto &node : children) {
+        if (node.elements) return &node;
+    }
+    return this;
+}
+
+}
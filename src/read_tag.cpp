@@ -1,27 +1,84 @@
 #include <nbtpp2/all_tags.hpp>
+#include <nbtpp2/number_list_tag.hpp>
+#include <nbtpp2/projection.hpp>
 
 namespace nbtpp2
 {
 
-Tag *read_tag(TagType type, BinaryReader &reader, Endianness endianness)
+Tag *read_tag(TagType type, BinaryReader &reader, Endianness endianness, const ReadOptions &options,
+              const Projection *projection)
+{
+    return endianness == Endianness::Big ? read_tag<Endianness::Big>(type, reader, options, projection)
+                                         : read_tag<Endianness::Little>(type, reader, options, projection);
+}
+
+template<Endianness E>
+Tag *read_tag(TagType type, BinaryReader &reader, const ReadOptions &options, const Projection *projection)
 {
     using namespace tags;
 
+    if (projection == nullptr && !options.paths.empty()) {
+        // Compile the paths once, the tags inside are read with the compiled projection
+        auto compiled = Projection{options.paths};
+        auto inner_options = options;
+        inner_options.paths.clear();
+        return read_tag<E>(type, reader, inner_options, &compiled);
+    }
+    if (projection != nullptr && projection->selects_all()) projection = nullptr;
+
+    // Scalars are read inline, so each endianness compiles to its own straight-line code
     switch (type) {
-    case TagType::TagByte: return TagByte::read(reader);
-    case TagType::TagShort: return TagShort::read(reader, endianness);
-    case TagType::TagInt: return TagInt::read(reader, endianness);
-    case TagType::TagLong: return TagLong::read(reader, endianness);
-    case TagType::TagFloat: return TagFloat::read(reader, endianness);
-    case TagType::TagDouble: return TagDouble::read(reader, endianness);
-    case TagType::TagByteArray: return TagByteArray::read(reader, endianness);
-    case TagType::TagString: return TagString::read(reader, endianness);
-    case TagType::TagList: return TagList::read(reader, endianness);
-    case TagType::TagCompound: return TagCompound::read(reader, endianness);
-    case TagType::TagIntArray: return TagIntArray::read(reader, endianness);
-    case TagType::TagLongArray: return TagLongArray::read(reader, endianness);
+    case TagType::TagByte: return new TagByte{read_number<E, std::int8_t, std::uint8_t>(reader)};
+    case TagType::TagShort: return new TagShort{read_number<E, std::int16_t, std::uint16_t>(reader)};
+    case TagType::TagInt: return new TagInt{read_number<E, std::int32_t, std::uint32_t>(reader)};
+    case TagType::TagLong: return new TagLong{read_number<E, std::int64_t, std::uint64_t>(reader)};
+    case TagType::TagFloat: return new TagFloat{read_number<E, float, std::uint32_t>(reader)};
+    case TagType::TagDouble: return new TagDouble{read_number<E, double, std::uint64_t>(reader)};
+    case TagType::TagByteArray: return TagByteArray::read(reader, E);
+    case TagType::TagString: return new TagString{read_string<E>(reader)};
+    case TagType::TagList: return read_list<E>(reader, options, projection);
+    case TagType::TagCompound: return TagCompound::read<E>(reader, options, projection);
+    case TagType::TagIntArray: return TagIntArray::read(reader, E);
+    case TagType::TagLongArray: return TagLongArray::read(reader, E);
     default: throw std::runtime_error("tag type not matched");
     }
 }
 
-}
\ No newline at end of file
+Tag *read_list(BinaryReader &reader, Endianness endianness, const ReadOptions &options,
+               const Projection *projection)
+{
+    return endianness == Endianness::Big ? read_list<Endianness::Big>(reader, options, projection)
+                                         : read_list<Endianness::Little>(reader, options, projection);
+}
+
+template<Endianness E>
+Tag *read_list(BinaryReader &reader, const ReadOptions &options, const Projection *projection)
+{
+    using namespace tags;
+
+    auto tag_type = read_tag_id(reader);
+    auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+    if (len < 0) len = 0;
+    if (!options.typed_lists || len == 0)
+        return TagList::read_elements<E>(reader, tag_type, len, options, projection);
+
+    switch (tag_type) {
+    case TagType::TagByte: return TagByteList::read_elements(reader, E, len);
+    case TagType::TagShort: return TagShortList::read_elements(reader, E, len);
+    case TagType::TagInt: return TagIntList::read_elements(reader, E, len);
+    case TagType::TagLong: return TagLongList::read_elements(reader, E, len);
+    case TagType::TagFloat: return TagFloatList::read_elements(reader, E, len);
+    case TagType::TagDouble: return TagDoubleList::read_elements(reader, E, len);
+    default: return TagList::read_elements<E>(reader, tag_type, len, options, projection);
+    }
+}
+
+template Tag *read_tag<Endianness::Big>(TagType, BinaryReader &, const ReadOptions &, const Projection *);
+
+template Tag *read_tag<Endianness::Little>(TagType, BinaryReader &, const ReadOptions &, const Projection *);
+
+template Tag *read_list<Endianness::Big>(BinaryReader &, const ReadOptions &, const Projection *);
+
+template Tag *read_list<Endianness::Little>(BinaryReader &, const ReadOptions &, const Projection *);
+
+}
@@ -0,0 +1,558 @@
+#include <nbtpp2/region_file.hpp>
+#include <nbtpp2/thread_pool.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdio>
+#include <ctime>
+#include <exception>
+#include <iterator>
+#include <memory>
+#include <mutex>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#else
+#include <dirent.h>
+#include <unistd.h>
+#endif
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+/// Largest sector offset a chunk location can hold (it has 24 bits)
+const std::uint32_t MAX_SECTOR_OFFSET = 0xFFFFFF;
+
+std::size_t chunk_index(int x, int z)
+{
+    return static_cast<std::size_t>((x & 31) + (z & 31) * 32);
+}
+
+void put_uint32(char *out, std::uint32_t value)
+{
+    for (std::size_t i = 0; i < 4; ++i) {
+        out[i] = static_cast<char>((value >> (24 - i * 8)) & 0xFFu);
+    }
+}
+
+// Flush a file to disk, so that it can safely replace another one
+bool sync_file(FILE *file)
+{
+    if (std::fflush(file) != 0) return false;
+#if defined(_WIN32)
+    return FlushFileBuffers(reinterpret_cast<HANDLE>(_get_osfhandle(_fileno(file)))) != 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+// Atomically replace the file at to by the file at from (the file at to stays intact if this fails)
+bool replace_file(const std::string &from, const std::string &to)
+{
+#if defined(_WIN32)
+    return MoveFileExA(from.c_str(), to.c_str(), MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH) != 0;
+#else
+    return std::rename(from.c_str(), to.c_str()) == 0;
+#endif
+}
+
+std::string external_chunk_path(const std::string &region_path, int x, int z)
+{
+    auto name_start = region_path.find_last_of("/\\");
+    name_start = name_start == std::string::npos ? 0 : name_start + 1;
+
+    int region_x = 0;
+    int region_z = 0;
+    // External chunks are named by absolute chunk coordinates, which need the region coordinates from the name
+    if (std::sscanf(region_path.c_str() + name_start, "r.%d.%d.", &region_x, &region_z) != 2) return "";
+
+    return region_path.substr(0, name_start) + "c." + std::to_string(region_x * 32 + (x & 31)) + "."
+        + std::to_string(region_z * 32 + (z & 31)) + ".mcc";
+}
+
+/**
+ * Tracks the outstanding jobs of a decode_regions call and the first error
+ */
+struct DecodeState
+{
+    std::mutex mutex;
+    std::condition_variable done;
+    std::size_t pending = 0;
+    std::exception_ptr error;
+
+    void start()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++pending;
+    }
+
+    void finish(std::exception_ptr job_error)
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        if (job_error && !error) error = job_error;
+        if (--pending == 0) done.notify_all();
+    }
+
+    bool failed()
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        return error != nullptr;
+    }
+};
+
+std::vector<std::string> list_region_directory(const std::string &directory)
+{
+    std::vector<std::string> names;
+#if defined(_WIN32)
+    WIN32_FIND_DATAA entry;
+    auto handle = FindFirstFileA((directory + "\\*.mca").c_str(), &entry);
+    if (handle == INVALID_HANDLE_VALUE) return names;
+    do {
+        names.emplace_back(entry.cFileName);
+    } while (FindNextFileA(handle, &entry));
+    FindClose(handle);
+#else
+    auto dir = opendir(directory.c_str());
+    if (dir == nullptr) return names;
+    while (auto entry = readdir(dir)) {
+        std::string name{entry->d_name};
+        if (name.size() > 4 && name.compare(name.size() - 4, 4, ".mca") == 0) names.push_back(name);
+    }
+    closedir(dir);
+#endif
+    return names;
+}
+
+NbtFile::Compression to_file_compression(RegionFile::ChunkCompression compression)
+{
+    switch (compression) {
+    case RegionFile::ChunkCompression::Gzip: return NbtFile::Compression::Gzip;
+    case RegionFile::ChunkCompression::Zlib: return NbtFile::Compression::Zlib;
+    case RegionFile::ChunkCompression::None: return NbtFile::Compression::None;
+    default: throw std::runtime_error("unsupported chunk compression");
+    }
+}
+
+}
+
+RegionFile::RegionFile(const std::string &path)
+    : path{path}, file{path}
+{
+    // New region files can be empty
+    if (file.size() == 0) return;
+    if (file.size() < 2 * REGION_SECTOR_SIZE)
+        throw std::runtime_error("region file is too small");
+
+    auto header = BufferReader{file.buffer(), 2 * REGION_SECTOR_SIZE};
+    for (auto &location : locations) {
+        location = read_number<std::uint32_t, std::uint32_t>(header, Endianness::Big);
+    }
+    for (auto &timestamp : timestamps) {
+        timestamp = read_number<std::uint32_t, std::uint32_t>(header, Endianness::Big);
+    }
+}
+
+std::size_t RegionFile::index(int x, int z)
+{
+    return chunk_index(x, z);
+}
+
+const std::string &RegionFile::get_path() const
+{
+    return path;
+}
+
+bool RegionFile::has_chunk(int x, int z) const
+{
+    return locations[index(x, z)] != 0;
+}
+
+std::uint32_t RegionFile::timestamp(int x, int z) const
+{
+    return timestamps[index(x, z)];
+}
+
+NbtFile RegionFile::read_chunk(int x, int z, const ReadOptions &options) const
+{
+    auto location = locations[index(x, z)];
+    if (location == 0)
+        throw std::runtime_error("chunk is not present in region file");
+
+    auto offset = static_cast<std::size_t>(location >> 8u) * REGION_SECTOR_SIZE;
+    auto sectors = static_cast<std::size_t>(location & 0xFFu);
+    if (offset < 2 * REGION_SECTOR_SIZE || offset + 5 > file.size())
+        throw std::runtime_error("chunk location is outside of region file");
+
+    auto chunk = BufferReader{file.buffer() + offset, file.size() - offset};
+    auto length = read_number<std::uint32_t, std::uint32_t>(chunk, Endianness::Big);
+    auto compression_id = read_number<std::uint8_t, std::uint8_t>(chunk, Endianness::Big);
+    if (length == 0 || length + 4 > sectors * REGION_SECTOR_SIZE || length + 4 > chunk.size())
+        throw std::runtime_error("chunk length does not fit its sectors");
+
+    // The upper bit marks chunks too big for the region file, stored in a separate file
+    auto compression = static_cast<ChunkCompression>(compression_id & 0x7Fu);
+    if (compression_id & 0x80u) return read_external_chunk(x, z, compression, options);
+
+    return NbtFile{chunk.read_ptr(length - 1), length - 1, Endianness::Big, to_file_compression(compression), options};
+}
+
+NbtFile RegionFile::read_external_chunk(int x, int z, ChunkCompression compression,
+                                        const ReadOptions &options) const
+{
+    auto chunk_path = external_chunk_path(path, x, z);
+    if (chunk_path.empty())
+        throw std::runtime_error("cannot locate external chunk of region file without an r.x.z name");
+    auto file_options = options;
+    file_options.in_memory = true;
+    return NbtFile{chunk_path, Endianness::Big, to_file_compression(compression), file_options};
+}
+
+RegionWriter::RegionWriter(const std::string &path)
+    : path{path}
+{
+    open();
+}
+
+RegionWriter::~RegionWriter()
+{
+    if (file != nullptr) std::fclose(file);
+}
+
+void RegionWriter::open()
+{
+    file = std::fopen(path.c_str(), "r+b");
+    if (file == nullptr) {
+        file = std::fopen(path.c_str(), "w+b");
+        if (file == nullptr) throw std::runtime_error("could not open region file");
+    }
+
+    std::fseek(file, 0, SEEK_END);
+    auto file_size = static_cast<std::size_t>(std::ftell(file));
+    std::rewind(file);
+
+    for (auto &location : locations) location = 0;
+    for (auto &timestamp : timestamps) timestamp = 0;
+    free_sectors.clear();
+
+    if (file_size == 0) {
+        auto header = std::vector<char>(2 * REGION_SECTOR_SIZE, 0);
+        write_at(0, header.data(), header.size());
+        file_sectors = 2;
+        return;
+    }
+    if (file_size < 2 * REGION_SECTOR_SIZE) {
+        std::fclose(file);
+        file = nullptr;
+        throw std::runtime_error("region file is too small");
+    }
+
+    auto header = std::vector<char>(2 * REGION_SECTOR_SIZE);
+    if (std::fread(header.data(), 1, header.size(), file) != header.size()) {
+        std::fclose(file);
+        file = nullptr;
+        throw std::runtime_error("could not read region file header");
+    }
+    auto reader = BufferReader{header};
+    for (auto &location : locations) {
+        location = read_number<std::uint32_t, std::uint32_t>(reader, Endianness::Big);
+    }
+    for (auto &timestamp : timestamps) {
+        timestamp = read_number<std::uint32_t, std::uint32_t>(reader, Endianness::Big);
+    }
+
+    file_sectors = static_cast<std::uint32_t>((file_size + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE);
+
+    // Everything after the header that no chunk claims is free
+    auto used = std::vector<bool>(file_sectors, false);
+    used[0] = used[1] = true;
+    for (auto location : locations) {
+        auto first = location >> 8u;
+        auto count = location & 0xFFu;
+        for (auto sector = first; sector < first + count && sector < file_sectors; ++sector) {
+            used[sector] = true;
+        }
+    }
+    for (std::uint32_t sector = 2; sector < file_sectors; ++sector) {
+        if (!used[sector]) release(sector, 1);
+    }
+}
+
+std::uint32_t RegionWriter::allocate(std::uint32_t count)
+{
+    for (auto it = free_sectors.begin(); it != free_sectors.end(); ++it) {
+        // Runs are ordered by offset, so no later run can be addressed either
+        if (it->first > MAX_SECTOR_OFFSET) break;
+        if (it->second < count) continue;
+        auto first = it->first;
+        auto remaining = it->second - count;
+        free_sectors.erase(it);
+        if (remaining > 0) free_sectors[first + count] = remaining;
+        return first;
+    }
+
+    // Grow the file, taking over a free run at its end if there is one
+    auto first = file_sectors;
+    if (!free_sectors.empty()) {
+        auto last = std::prev(free_sectors.end());
+        if (last->first + last->second == file_sectors) {
+            first = last->first;
+        }
+    }
+    if (first > MAX_SECTOR_OFFSET) throw std::runtime_error("region file is full");
+    if (first != file_sectors) free_sectors.erase(std::prev(free_sectors.end()));
+    file_sectors = first + count;
+    return first;
+}
+
+void RegionWriter::release(std::uint32_t first, std::uint32_t count)
+{
+    if (count == 0) return;
+    if (first + count > file_sectors) {
+        if (first >= file_sectors) return;
+        count = file_sectors - first;
+    }
+
+    // Merge with the neighbouring free runs
+    auto next = free_sectors.lower_bound(first);
+    if (next != free_sectors.end() && first + count == next->first) {
+        count += next->second;
+        next = free_sectors.erase(next);
+    }
+    if (next != free_sectors.begin()) {
+        auto previous = std::prev(next);
+        if (previous->first + previous->second == first) {
+            previous->second += count;
+            return;
+        }
+    }
+    free_sectors[first] = count;
+}
+
+void RegionWriter::write_at(std::size_t offset, const char *data, std::size_t size)
+{
+    if (std::fseek(file, static_cast<long>(offset), SEEK_SET) != 0 || std::fwrite(data, 1, size, file) != size)
+        throw std::runtime_error("could not write to region file");
+}
+
+void RegionWriter::write_entry(std::size_t index)
+{
+    char entry[4];
+    put_uint32(entry, locations[index]);
+    write_at(index * 4, entry, sizeof(entry));
+    put_uint32(entry, timestamps[index]);
+    write_at(REGION_SECTOR_SIZE + index * 4, entry, sizeof(entry));
+    std::fflush(file);
+}
+
+void RegionWriter::write_payload(int x, int z, const char *data, std::size_t size, RegionFile::ChunkCompression compression,
+                                 std::uint32_t timestamp)
+{
+    auto index = chunk_index(x, z);
+    auto compression_id = static_cast<char>(compression);
+    auto sectors = (size + 5 + REGION_SECTOR_SIZE - 1) / REGION_SECTOR_SIZE;
+
+    auto external_path = external_chunk_path(path, x, z);
+    auto external = sectors > 0xFF;
+    auto block = std::vector<char>{};
+    if (external) {
+        if (external_path.empty())
+            throw std::runtime_error("cannot store external chunk of region file without an r.x.z name");
+        // Renamed into place, so that a crash leaves either the old or the new chunk, never a partial one
+        auto temp_path = external_path + ".tmp";
+        auto temp = std::fopen(temp_path.c_str(), "wb");
+        if (temp == nullptr)
+            throw std::runtime_error("could not open external chunk file");
+        auto ok = std::fwrite(data, 1, size, temp) == size && sync_file(temp);
+        ok = std::fclose(temp) == 0 && ok;
+        if (!ok || !replace_file(temp_path, external_path)) {
+            std::remove(temp_path.c_str());
+            throw std::runtime_error("could not write external chunk file");
+        }
+
+        block.assign(REGION_SECTOR_SIZE, 0);
+        put_uint32(block.data(), 1);
+        block[4] = static_cast<char>(compression_id | 0x80);
+        sectors = 1;
+    }
+    else {
+        block.assign(sectors * REGION_SECTOR_SIZE, 0);
+        put_uint32(block.data(), static_cast<std::uint32_t>(size + 1));
+        block[4] = compression_id;
+        std::copy(data, data + size, block.begin() + 5);
+    }
+
+    auto old_location = locations[index];
+    auto first = allocate(static_cast<std::uint32_t>(sectors));
+    write_at(static_cast<std::size_t>(first) * REGION_SECTOR_SIZE, block.data(), block.size());
+
+    locations[index] = first << 8u | static_cast<std::uint32_t>(sectors);
+    timestamps[index] = timestamp;
+    write_entry(index);
+    release(old_location >> 8u, old_location & 0xFFu);
+
+    // A stale external copy of the chunk is only dropped once nothing refers to it anymore
+    if (!external && !external_path.empty()) std::remove(external_path.c_str());
+}
+
+void RegionWriter::write_chunk(int x, int z, NbtFile &chunk, RegionFile::ChunkCompression compression,
+                               const WriteOptions &options)
+{
+    auto writer = BufferWriter{};
+    chunk.write(writer, Endianness::Big, to_file_compression(compression), options);
+    write_payload(x, z, writer.data(), writer.size(), compression, static_cast<std::uint32_t>(std::time(nullptr)));
+}
+
+void RegionWriter::remove_chunk(int x, int z)
+{
+    auto index = chunk_index(x, z);
+    auto old_location = locations[index];
+    if (old_location == 0) return;
+
+    locations[index] = 0;
+    timestamps[index] = 0;
+    write_entry(index);
+    release(old_location >> 8u, old_location & 0xFFu);
+
+    auto external_path = external_chunk_path(path, x, z);
+    if (!external_path.empty()) std::remove(external_path.c_str());
+}
+
+std::uint32_t RegionWriter::free_sector_count() const
+{
+    auto count = std::uint32_t{0};
+    for (auto &run : free_sectors) {
+        count += run.second;
+    }
+    return count;
+}
+
+std::uint32_t RegionWriter::sector_count() const
+{
+    return file_sectors;
+}
+
+void RegionWriter::compact()
+{
+    std::fflush(file);
+
+    auto temp_path = path + ".tmp";
+    auto temp = std::fopen(temp_path.c_str(), "wb");
+    if (temp == nullptr) throw std::runtime_error("could not create temporary region file");
+
+    auto new_locations = std::vector<std::uint32_t>(REGION_CHUNKS, 0);
+    auto buffer = std::vector<char>{};
+    auto next_sector = std::uint32_t{2};
+    auto ok = std::fseek(temp, static_cast<long>(2 * REGION_SECTOR_SIZE), SEEK_SET) == 0;
+
+    // Copy the sectors of every chunk in file order, so the new file is read sequentially
+    auto order = std::vector<std::size_t>{};
+    for (std::size_t index = 0; index < REGION_CHUNKS; ++index) {
+        if (locations[index] != 0) order.push_back(index);
+    }
+    std::sort(order.begin(), order.end(), [this](std::size_t a, std::size_t b) { return locations[a] < locations[b]; });
+
+    for (auto index : order) {
+        if (!ok) break;
+        auto count = locations[index] & 0xFFu;
+        buffer.resize(count * REGION_SECTOR_SIZE);
+        ok = std::fseek(file, static_cast<long>((locations[index] >> 8u) * REGION_SECTOR_SIZE), SEEK_SET) == 0
+            && std::fread(buffer.data(), 1, buffer.size(), file) == buffer.size()
+            && std::fwrite(buffer.data(), 1, buffer.size(), temp) == buffer.size();
+        new_locations[index] = next_sector << 8u | count;
+        next_sector += count;
+    }
+
+    auto header = std::vector<char>(2 * REGION_SECTOR_SIZE, 0);
+    for (std::size_t index = 0; index < REGION_CHUNKS; ++index) {
+        put_uint32(&header[index * 4], new_locations[index]);
+        put_uint32(&header[REGION_SECTOR_SIZE + index * 4], timestamps[index]);
+    }
+    ok = ok && std::fseek(temp, 0, SEEK_SET) == 0 && std::fwrite(header.data(), 1, header.size(), temp) == header.size();
+    ok = ok && sync_file(temp);
+    ok = std::fclose(temp) == 0 && ok;
+    if (!ok) {
+        std::remove(temp_path.c_str());
+        throw std::runtime_error("could not write compacted region file");
+    }
+
+    // Renamed over the original, so that there is always a complete region file at path
+    std::fclose(file);
+    file = nullptr;
+    auto replaced = replace_file(temp_path, path);
+    if (!replaced) std::remove(temp_path.c_str());
+    open();
+    if (!replaced) throw std::runtime_error("could not replace region file with compacted region file");
+}
+
+void decode_regions(const std::vector<std::string> &paths, const ChunkCallback &callback, unsigned threads,
+                    const ReadOptions &options)
+{
+    DecodeState state;
+    ThreadPool pool{threads};
+
+    for (const auto &path : paths) {
+        state.start();
+        pool.submit([&, path]()
+        {
+            std::exception_ptr error;
+            try {
+                auto region = std::make_shared<RegionFile>(path);
+                for (int z = 0; z < 32; ++z) {
+                    for (int x = 0; x < 32; ++x) {
+                        if (!region->has_chunk(x, z)) continue;
+                        // Submitted from a worker, so the chunks queue up locally and idle workers steal them
+                        state.start();
+                        pool.submit([&, region, x, z]()
+                        {
+                            std::exception_ptr chunk_error;
+                            try {
+                                if (!state.failed()) {
+                                    auto chunk = region->read_chunk(x, z, options);
+                                    callback(region->get_path(), x, z, chunk);
+                                }
+                            } catch (...) {
+                                chunk_error = std::current_exception();
+                            }
+                            state.finish(chunk_error);
+                        });
+                    }
+                }
+            } catch (...) {
+                error = std::current_exception();
+            }
+            state.finish(error);
+        });
+    }
+
+    std::unique_lock<std::mutex> lock{state.mutex};
+    state.done.wait(lock, [&]() { return state.pending == 0; });
+    if (state.error) std::rethrow_exception(state.error);
+}
+
+std::vector<std::string> find_region_files(const std::string &world_path)
+{
+    std::vector<std::string> paths;
+    for (const auto *dimension : {"", "DIM-1/", "DIM1/"}) {
+        auto directory = world_path + "/" + dimension + "region";
+        auto names = list_region_directory(directory);
+        std::sort(names.begin(), names.end());
+        for (const auto &name : names) {
+            paths.push_back(directory + "/" + name);
+        }
+    }
+    return paths;
+}
+
+void decode_world(const std::string &world_path, const ChunkCallback &callback, unsigned threads,
+                  const ReadOptions &options)
+{
+    decode_regions(find_region_files(world_path), callback, threads, options);
+}
+
+}
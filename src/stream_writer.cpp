@@ -0,0 +1,172 @@
+#include <nbtpp2/stream_writer.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <stdexcept>
+
+namespace nbtpp2
+{
+
+NbtStreamWriter::NbtStreamWriter(BinaryWriter &writer, Endianness endianness)
+    : writer(writer), buffer{dynamic_cast<BufferWriter *>(&writer)}, endianness{endianness}
+{}
+
+void NbtStreamWriter::begin_tag(TagType type, const std::string &name)
+{
+    if (frames.empty()) {
+        if (root_written) throw std::runtime_error("the root tag has already been written");
+        root_written = true;
+        write_tag_id(type, writer);
+        nbtpp2::write_string(name, writer, endianness);
+        return;
+    }
+
+    auto &frame = frames.back();
+    if (frame.container == TagType::TagCompound) {
+        write_tag_id(type, writer);
+        nbtpp2::write_string(name, writer, endianness);
+        return;
+    }
+
+    if (type != frame.element_type)
+        throw std::runtime_error("cannot write a " + tag_type_to_string(type) + " to a list of "
+                                 + tag_type_to_string(frame.element_type));
+    if (frame.length >= 0 && frame.written == frame.length)
+        throw std::runtime_error("more elements written to a list than declared");
+    ++frame.written;
+}
+
+void NbtStreamWriter::push(const Frame &frame)
+{
+    frames.push_back(frame);
+}
+
+NbtStreamWriter::Frame NbtStreamWriter::pop(TagType container)
+{
+    if (frames.empty() || frames.back().container != container)
+        throw std::runtime_error("not writing a " + tag_type_to_string(container));
+    auto frame = frames.back();
+    frames.pop_back();
+    return frame;
+}
+
+void NbtStreamWriter::begin_compound(const std::string &name)
+{
+    begin_tag(TagType::TagCompound, name);
+    push(Frame{TagType::TagCompound, TagType::TagEnd, 0, 0, 0});
+}
+
+void NbtStreamWriter::end_compound()
+{
+    pop(TagType::TagCompound);
+    write_tag_id(TagType::TagEnd, writer);
+}
+
+void NbtStreamWriter::begin_list(const std::string &name, TagType element_type, std::int32_t length)
+{
+    if (length < 0) throw std::runtime_error("negative list length");
+    if (length > 0 && element_type == TagType::TagEnd)
+        throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
+    begin_tag(TagType::TagList, name);
+    write_tag_id(element_type, writer);
+    write_number<std::int32_t, std::uint32_t>(length, writer, endianness);
+    push(Frame{TagType::TagList, element_type, length, 0, 0});
+}
+
+void NbtStreamWriter::begin_list(const std::string &name, TagType element_type)
+{
+    if (buffer == nullptr) throw std::runtime_error("list lengths can only be filled in afterwards in a BufferWriter");
+    begin_tag(TagType::TagList, name);
+    write_tag_id(element_type, writer);
+    auto length_offset = buffer->size();
+    write_number<std::int32_t, std::uint32_t>(0, writer, endianness);
+    push(Frame{TagType::TagList, element_type, -1, 0, length_offset});
+}
+
+void NbtStreamWriter::end_list()
+{
+    if (!frames.empty() && frames.back().container == TagType::TagList && frames.back().written < frames.back().length)
+        throw std::runtime_error("fewer elements written to a list than declared");
+    auto frame = pop(TagType::TagList);
+    if (frame.length >= 0) return;
+    if (frame.written > 0 && frame.element_type == TagType::TagEnd)
+        throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
+
+    SpanWriter length{buffer->buffer().data() + frame.length_offset, sizeof(std::int32_t)};
+    write_number<std::int32_t, std::uint32_t>(frame.written, length, endianness);
+}
+
+void NbtStreamWriter::write_byte(const std::string &name, std::int8_t value)
+{
+    begin_tag(TagType::TagByte, name);
+    write_number<std::int8_t, std::uint8_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_short(const std::string &name, std::int16_t value)
+{
+    begin_tag(TagType::TagShort, name);
+    write_number<std::int16_t, std::uint16_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_int(const std::string &name, std::int32_t value)
+{
+    begin_tag(TagType::TagInt, name);
+    write_number<std::int32_t, std::uint32_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_long(const std::string &name, std::int64_t value)
+{
+    begin_tag(TagType::TagLong, name);
+    write_number<std::int64_t, std::uint64_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_float(const std::string &name, float value)
+{
+    begin_tag(TagType::TagFloat, name);
+    write_number<float, std::uint32_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_double(const std::string &name, double value)
+{
+    begin_tag(TagType::TagDouble, name);
+    write_number<double, std::uint64_t>(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_string(const std::string &name, const std::string &value)
+{
+    begin_tag(TagType::TagString, name);
+    nbtpp2::write_string(value, writer, endianness);
+}
+
+void NbtStreamWriter::write_byte_array(const std::string &name, const std::int8_t *data, std::size_t size)
+{
+    begin_tag(TagType::TagByteArray, name);
+    write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(size), writer, endianness);
+    write_numbers<std::int8_t, std::uint8_t>(data, size, writer, endianness);
+}
+
+void NbtStreamWriter::write_int_array(const std::string &name, const std::int32_t *data, std::size_t size)
+{
+    begin_tag(TagType::TagIntArray, name);
+    write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(size), writer, endianness);
+    write_numbers<std::int32_t, std::uint32_t>(data, size, writer, endianness);
+}
+
+void NbtStreamWriter::write_long_array(const std::string &name, const std::int64_t *data, std::size_t size)
+{
+    begin_tag(TagType::TagLongArray, name);
+    write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(size), writer, endianness);
+    write_numbers<std::int64_t, std::uint64_t>(data, size, writer, endianness);
+}
+
+void NbtStreamWriter::write_tag(const std::string &name, Tag &tag)
+{
+    begin_tag(tag.identify(), name);
+    tag.write(writer, endianness);
+}
+
+std::size_t NbtStreamWriter::depth() const
+{
+    return frames.size();
+}
+
+}
@@ -1,4 +1,5 @@
 #include <nbtpp2/tag.hpp>
+#include <nbtpp2/arena.hpp>
 
 namespace nbtpp2
 {
@@ -7,9 +8,34 @@ Tag::Tag(TagType type)
     : type{type}
 {}
 
-TagType Tag::identify()
+Tag::Tag(TagType type, bool lazy)
+    : type{type}, lazy{lazy}
+{}
+
+std::size_t Tag::serialized_size() const
+{
+    // Writing does not modify the tag, it only is not declared const
+    CountingWriter counter;
+    const_cast<Tag *>(this)->write(counter, SYSTEM_ENDIANNESS);
+    return counter.size();
+}
+
+TagType Tag::identify() const
 {
     return type;
 }
 
-}
\ No newline at end of file
+void *Tag::operator new(std::size_t size)
+{
+    auto arena = Arena::current();
+    return arena != nullptr ? arena->allocate(size) : ::operator new(size);
+}
+
+void Tag::operator delete(void *ptr)
+{
+    // Arena memory is only freed with its arena
+    if (ptr == nullptr || Arena::owns(ptr)) return;
+    ::operator delete(ptr);
+}
+
+}
@@ -1,9 +1,12 @@
 #include <nbtpp2/util.hpp>
 #include <nbtpp2/tags/tag_compound.hpp>
 
+#include <memory>
 #include <utility>
 #include <iostream>
 #include <nbtpp2/all_tags.hpp>
+#include <nbtpp2/lazy_tag.hpp>
+#include <nbtpp2/projection.hpp>
 
 namespace nbtpp2
 {
@@ -17,26 +20,74 @@ TagCompound::TagCompound(ValT value)
 
 void TagCompound::write(BinaryWriter &writer, Endianness endianness)
 {
-    for (auto &it : value) {
+    if (endianness == Endianness::Big) write_entries<Endianness::Big>(writer);
+    else write_entries<Endianness::Little>(writer);
+}
+
+template<Endianness E>
+void TagCompound::write_entries(BinaryWriter &writer)
+{
+    // Unparsed entries are written without parsing them
+    for (auto &it : value.raw_entries()) {
         write_tag_id(it.second->identify(), writer);
-        write_string(it.first, writer, endianness);
-        it.second->write(writer, endianness);
+        write_string<E>(it.first, writer);
+        it.second->write(writer, E);
     }
     write_tag_id(TagType::TagEnd, writer);
 }
 
-TagCompound *TagCompound::read(BinaryReader &reader, Endianness endianness)
+std::size_t TagCompound::serialized_size() const
+{
+    std::size_t size = 1;
+    for (auto &it : value.raw_entries()) {
+        size += 1 + sizeof(std::uint16_t) + static_cast<std::uint16_t>(it.first.str().size())
+                + it.second->serialized_size();
+    }
+    return size;
+}
+
+TagCompound *TagCompound::read(BinaryReader &reader, Endianness endianness, const ReadOptions &options,
+                               const Projection *projection)
+{
+    return endianness == Endianness::Big ? read<Endianness::Big>(reader, options, projection)
+                                         : read<Endianness::Little>(reader, options, projection);
+}
+
+template<Endianness E>
+TagCompound *TagCompound::read(BinaryReader &reader, const ReadOptions &options, const Projection *projection)
 {
-    auto tc = new TagCompound{{}};
+    // Owned until fully read, so that the entries read so far are freed if reading throws
+    std::unique_ptr<TagCompound> tc{new TagCompound{{}}};
     while (true) {
         auto id = read_tag_id(reader);
         if (id == TagType::TagEnd) break;
-        auto name = read_string(reader, endianness);
-        tc->value[name] = read_tag(id, reader, endianness);
+        auto name = read_key<E>(reader);
+        auto selected = projection != nullptr ? projection->field(name) : nullptr;
+        if (projection != nullptr && selected == nullptr) {
+            skip_tag(id, reader, E);
+            continue;
+        }
+        // Entries only partly selected are read right away, to apply the rest of the projection
+        if (selected != nullptr && !selected->selects_all())
+            tc->value.append(name, read_tag<E>(id, reader, options, selected));
+        else if (!options.lazy)
+            tc->value.append(name, read_tag<E>(id, reader, options));
+        else {
+            auto tag = LazyTag::read(id, reader, E, options);
+            tc->value.append(name, tag, tag->is_lazy());
+        }
+    }
+    // Sorted and indexed once, instead of on every entry; tags of repeated names are replaced by the last one
+    for (auto replaced : tc->value.finish_append()) {
+        delete replaced;
     }
-    return tc;
+    return tc.release();
 }
 
+template TagCompound *TagCompound::read<Endianness::Big>(BinaryReader &, const ReadOptions &, const Projection *);
+
+template TagCompound *TagCompound::read<Endianness::Little>(BinaryReader &, const ReadOptions &, const Projection *);
+
 Tag *TagCompound::traverse(std::vector<std::string> path_parts)
 {
     if (!path_parts.empty()) {
@@ -52,7 +103,7 @@ Tag *TagCompound::traverse(std::vector<std::string> path_parts)
                 }
             );
         case TagType::TagList:
-            return value[path_parts[0]]->as<TagList>().traverse(
+            return TagList::expand(value[path_parts[0]]).traverse(
                 std::vector<std::string>{
                     path_parts.begin() + 1,
                     path_parts.end()
@@ -65,6 +116,13 @@ Tag *TagCompound::traverse(std::vector<std::string> path_parts)
     return this;
 }
 
+TagCompound::~TagCompound()
+{
+    for (auto &it : value.raw_entries()) {
+        delete it.second;
+    }
 }
 
-}
\ No newline at end of file
+}
+
+}
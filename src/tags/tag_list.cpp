@@ -1,6 +1,9 @@
 #include <nbtpp2/tags/tag_list.hpp>
 #include <nbtpp2/util.hpp>
 #include <nbtpp2/all_tags.hpp>
+#include <nbtpp2/projection.hpp>
+
+#include <memory>
 
 namespace nbtpp2
 {
@@ -8,6 +11,31 @@ namespace nbtpp2
 namespace tags
 {
 
+namespace
+{
+
+/**
+ * @brief Convert a typed list to a TagList
+ * @tparam ListT NumberListTag to convert from
+ * @tparam ElementT Tag class of the elements
+ * @param tag Tag to convert
+ * @return The converted list (owned by the caller), or nullptr if @p tag is not a ListT
+ */
+template<typename ListT, typename ElementT>
+TagList *expand_number_list(Tag *tag)
+{
+    auto typed = dynamic_cast<ListT *>(tag);
+    if (typed == nullptr) return nullptr;
+    std::unique_ptr<TagList> list{new TagList{{}}};
+    list->value.reserve(typed->value.size());
+    for (auto number : typed->value) {
+        list->value.push_back(new ElementT{number});
+    }
+    return list.release();
+}
+
+}
+
 TagList::TagList(ValT value)
     : Tag{TagType::TagList}, value{std::move(value)}
 {
@@ -19,34 +47,88 @@ TagList::TagList(ValT value)
 }
 
 void TagList::write(BinaryWriter &writer, Endianness endianness)
+{
+    if (endianness == Endianness::Big) write_elements<Endianness::Big>(writer);
+    else write_elements<Endianness::Little>(writer);
+}
+
+template<Endianness E>
+void TagList::write_elements(BinaryWriter &writer)
 {
     auto expected_tag_type = value.empty() ? TagType::TagEnd : value[0]->identify();
     write_tag_id(expected_tag_type, writer);
-    write_number<std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer, endianness);
+    write_number<E, std::int32_t, std::uint32_t>(static_cast<std::int32_t>(value.size()), writer);
     auto i = std::int32_t{0};
     for (auto &it : value) {
         ++i;
-        it->write(writer, endianness);
+        it->write(writer, E);
         if (i == INT32_MAX) break;
     }
 }
 
-TagList *TagList::read(BinaryReader &reader, Endianness endianness)
+std::size_t TagList::serialized_size() const
+{
+    std::size_t size = 1 + sizeof(std::int32_t);
+    for (auto &it : value) {
+        size += it->serialized_size();
+    }
+    return size;
+}
+
+TagList *TagList::read(BinaryReader &reader, Endianness endianness, const ReadOptions &options)
 {
-    auto tl = new TagList{{}};
     auto tag_type = read_tag_id(reader);
     auto len = read_number<std::int32_t, std::uint32_t>(reader, endianness);
-    tl->value.reserve(len);
+    return read_elements(reader, endianness, tag_type, len, options);
+}
+
+TagList *TagList::read_elements(BinaryReader &reader, Endianness endianness, TagType tag_type, std::int32_t len,
+                                const ReadOptions &options, const Projection *projection)
+{
+    return endianness == Endianness::Big ? read_elements<Endianness::Big>(reader, tag_type, len, options, projection)
+                                         : read_elements<Endianness::Little>(reader, tag_type, len, options, projection);
+}
+
+template<Endianness E>
+TagList *TagList::read_elements(BinaryReader &reader, TagType tag_type, std::int32_t len, const ReadOptions &options,
+                                const Projection *projection)
+{
+    auto element = projection != nullptr ? projection->element() : nullptr;
+    // Owned until fully read, so that the elements read so far are freed if reading throws
+    std::unique_ptr<TagList> tl{new TagList{{}}};
     if (len > 0) {
-        if (tag_type == TagType::TagEnd) {
+        if (tag_type == TagType::TagEnd)
             throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
-        }
+        tl->value.reserve(len);
         for (std::int32_t i = 0; i < len; ++i) {
-            tl->value.push_back(read_tag(tag_type, reader, endianness));
+            tl->value.push_back(read_tag<E>(tag_type, reader, options, element));
         }
     }
 
-    return tl;
+    return tl.release();
+}
+
+template TagList *TagList::read_elements<Endianness::Big>(BinaryReader &, TagType, std::int32_t, const ReadOptions &,
+                                                          const Projection *);
+
+template TagList *TagList::read_elements<Endianness::Little>(BinaryReader &, TagType, std::int32_t,
+                                                             const ReadOptions &, const Projection *);
+
+TagList &TagList::expand(Tag *&tag)
+{
+    if (auto list = dynamic_cast<TagList *>(tag)) return *list;
+
+    auto list = expand_number_list<TagByteList, TagByte>(tag);
+    if (list == nullptr) list = expand_number_list<TagShortList, TagShort>(tag);
+    if (list == nullptr) list = expand_number_list<TagIntList, TagInt>(tag);
+    if (list == nullptr) list = expand_number_list<TagLongList, TagLong>(tag);
+    if (list == nullptr) list = expand_number_list<TagFloatList, TagFloat>(tag);
+    if (list == nullptr) list = expand_number_list<TagDoubleList, TagDouble>(tag);
+    if (list == nullptr) throw std::runtime_error("error casting tag to desired type");
+
+    delete tag;
+    tag = list;
+    return *list;
 }
 
 Tag *TagList::traverse(std::vector<std::string> path_parts)
@@ -65,7 +147,7 @@ Tag *TagList::traverse(std::vector<std::string> path_parts)
                 }
             );
         case TagType::TagList:
-            return value[idx]->as<TagList>().traverse(
+            return expand(value[idx]).traverse(
                 std::vector<std::string>{
                     path_parts.begin() + 1,
                     path_parts.end()
@@ -16,6 +16,12 @@ void TagString::write(BinaryWriter &writer, Endianness endianness)
     write_string(value, writer, endianness);
 }
 
+std::size_t TagString::serialized_size() const
+{
+    // write_string() writes at most 65535 bytes
+    return sizeof(std::uint16_t) + static_cast<std::uint16_t>(value.size());
+}
+
 TagString *TagString::read(BinaryReader &reader, Endianness endianness)
 {
     return new TagString{read_string(reader, endianness)};
@@ -2,6 +2,29 @@
 #include "catch.hpp"
 #include "nbtpp2/all_tags.hpp"
 #include "nbtpp2/nbt_file.hpp"
+#include "nbtpp2/region_file.hpp"
+#include "nbtpp2/cursor.hpp"
+#include "nbtpp2/projection.hpp"
+#include "nbtpp2/binding.hpp"
+#include "nbtpp2/stream_writer.hpp"
+#include "nbtpp2/patch.hpp"
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <sstream>
+#include <thread>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
 
 template <typename T, typename TUnsigned>
 void as_bytes(const T * input, std::size_t in_size, std::vector<char> &output, nbtpp2::Endianness endianness) {
@@ -35,6 +58,66 @@ struct membuf: std::streambuf
     }
 };
 
+struct BigTestItem
+{
+    std::string name;
+    std::int64_t created_on = 0;
+};
+
+NBTPP2_BINDING(BigTestItem,
+               nbtpp2::field("name", &BigTestItem::name),
+               nbtpp2::field("created-on", &BigTestItem::created_on))
+
+struct BigTestFood
+{
+    std::string name;
+    float value = 0;
+};
+
+NBTPP2_BINDING(BigTestFood,
+               nbtpp2::field("name", &BigTestFood::name),
+               nbtpp2::field("value", &BigTestFood::value))
+
+struct BigTestNested
+{
+    BigTestFood egg;
+    BigTestFood ham;
+};
+
+NBTPP2_BINDING(BigTestNested,
+               nbtpp2::field("egg", &BigTestNested::egg),
+               nbtpp2::field("ham", &BigTestNested::ham))
+
+// Leaves out the byte array and the short, which are skipped
+struct BigTest
+{
+    std::int32_t int_test = 0;
+    std::int64_t long_test = 0;
+    std::string string_test;
+    double double_test = 0;
+    bool byte_test = false;
+    BigTestNested nested;
+    std::vector<std::int64_t> longs;
+    std::vector<BigTestItem> items;
+};
+
+NBTPP2_BINDING(BigTest,
+               nbtpp2::field("intTest", &BigTest::int_test),
+               nbtpp2::field("longTest", &BigTest::long_test),
+               nbtpp2::field("stringTest", &BigTest::string_test),
+               nbtpp2::field("doubleTest", &BigTest::double_test),
+               nbtpp2::field("byteTest", &BigTest::byte_test),
+               nbtpp2::field("nested compound test", &BigTest::nested),
+               nbtpp2::list_field("listTest (long)", &BigTest::longs),
+               nbtpp2::field("listTest (compound)", &BigTest::items))
+
+struct Mismatched
+{
+    std::string int_test;
+};
+
+NBTPP2_BINDING(Mismatched, nbtpp2::field("intTest", &Mismatched::int_test))
+
 TEST_CASE("TAG_Byte", "[tag_byte]")
 {
     char contents[] = {0x20};
@@ -138,6 +221,68 @@ auto random_t_array(std::size_t len, TUnsigned minimum)
     return out;
 }
 
+// The uncompressed contents of bigtest.nbt
+std::vector<char> inflated_bigtest()
+{
+    nbtpp2::MmapReader compressed{"bigtest.nbt"};
+    auto inflated = std::vector<char>{};
+    nbtpp2::inflate_buffer(compressed.buffer(), compressed.size(), inflated);
+    return inflated;
+}
+
+std::vector<char> uncompressed_bigtest(nbtpp2::Endianness endianness)
+{
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+    auto writer = nbtpp2::BufferWriter{};
+    file.write(writer, endianness, nbtpp2::NbtFile::Compression::None);
+    return std::vector<char>(writer.data(), writer.data() + writer.size());
+}
+
+// Set to make every allocation on other threads than allocating_thread fail, to test how worker errors are handled
+std::atomic<bool> fail_other_thread_allocations{false};
+std::thread::id allocating_thread;
+
+void *operator new(std::size_t size)
+{
+    if (fail_other_thread_allocations && std::this_thread::get_id() != allocating_thread) throw std::bad_alloc{};
+    if (auto ptr = std::malloc(size == 0 ? 1 : size)) return ptr;
+    throw std::bad_alloc{};
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    try {
+        return operator new(size);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void operator delete(void *ptr) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, const std::nothrow_t &) noexcept
+{
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept
+{
+    std::free(ptr);
+}
+
+// Create a directory, succeeding if it already exists
+bool make_directory(const std::string &path)
+{
+#ifdef _WIN32
+    return _mkdir(path.c_str()) == 0 || errno == EEXIST;
+#else
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+#endif
+}
+
 TEST_CASE("TAG_String", "[tag_string]")
 {
     GIVEN("A random string of numbers and letters with the length of 257") {
@@ -288,3 +433,1094 @@ TEST_CASE("ZLIB read", "[compression]")
     auto file = nbtpp2::NbtFile{"test.z.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Zlib};
     file.write("test.unz.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::None);
 }
+
+TEST_CASE("Uncompressed read", "[mmap]")
+{
+    auto file = nbtpp2::NbtFile{"test.unz.nbt", nbtpp2::Endianness::Big};
+    REQUIRE(file.root_name == "apples");
+    REQUIRE(file.get_root_tag_compound()["beer"]->as<nbtpp2::tags::TagByte>().value == 3);
+
+    nbtpp2::MmapReader reader{"test.unz.nbt"};
+    REQUIRE(*reader.read_ptr(1) == static_cast<char>(nbtpp2::TagType::TagCompound));
+    REQUIRE(reader.position() == 1);
+    REQUIRE_THROWS(reader.read_ptr(static_cast<std::uint32_t>(reader.size())));
+}
+
+TEST_CASE("Buffer round trip", "[buffer]")
+{
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+
+    for (auto compression : {nbtpp2::NbtFile::Compression::None, nbtpp2::NbtFile::Compression::Gzip,
+                             nbtpp2::NbtFile::Compression::Zlib}) {
+        auto writer = nbtpp2::BufferWriter{};
+        file.write(writer, nbtpp2::Endianness::Big, compression);
+
+        auto copy = nbtpp2::NbtFile{writer.data(), writer.size(), nbtpp2::Endianness::Big};
+        REQUIRE(copy.root_name == "Level");
+        REQUIRE(copy.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+        REQUIRE(copy.get_root_tag_compound()["longTest"]->as<nbtpp2::tags::TagLong>().value == 9223372036854775807);
+    }
+
+    char truncated[] = {0x0a, 0x00, 0x01, 'a', 0x03, 0x00};
+    REQUIRE_THROWS(nbtpp2::NbtFile(truncated, sizeof(truncated), nbtpp2::Endianness::Big));
+}
+
+TEST_CASE("ZLIB streaming read", "[compression]")
+{
+    auto values = random_t_array<std::int8_t, std::uint8_t, UINT8_MAX>(400000, 0);
+    auto file = nbtpp2::NbtFile{"streaming"};
+    file.get_root_tag_compound()["values"] = new nbtpp2::tags::TagByteArray{values};
+    file.get_root_tag_compound()["after"] = new nbtpp2::tags::TagString{"end"};
+    file.write("test.stream.z.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Zlib);
+
+    auto read = nbtpp2::NbtFile{"test.stream.z.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Zlib};
+    REQUIRE(read.get_root_tag_compound()["values"]->as<nbtpp2::tags::TagByteArray>().value == values);
+    REQUIRE(read.get_root_tag_compound()["after"]->as<nbtpp2::tags::TagString>().value == "end");
+
+#ifndef _WIN32
+    // Pipes cannot be seeked
+    auto pipe = popen("cat test.stream.z.nbt", "r");
+    {
+        nbtpp2::ZlibReader reader{pipe};
+        REQUIRE(nbtpp2::read_tag_id(reader) == nbtpp2::TagType::TagCompound);
+        REQUIRE(nbtpp2::read_string(reader, nbtpp2::Endianness::Big) == "streaming");
+    }
+    pclose(pipe);
+#endif
+}
+
+TEST_CASE("In-memory read", "[compression]")
+{
+    auto options = nbtpp2::ReadOptions{};
+    options.in_memory = true;
+
+    auto gzip = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    REQUIRE(gzip.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+
+    auto zlib = nbtpp2::NbtFile{"test.z.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    REQUIRE(zlib.get_root_tag_compound()["beer"]->as<nbtpp2::tags::TagByte>().value == 3);
+
+    auto inflated = inflated_bigtest();
+    REQUIRE(inflated.size() == 1544);
+    REQUIRE(inflated.capacity() == inflated.size());
+}
+
+TEST_CASE("Parallel gzip write", "[compression]")
+{
+    auto values = random_t_array<std::int8_t, std::uint8_t, 3>(300000, 0);
+    auto file = nbtpp2::NbtFile{"parallel"};
+    file.get_root_tag_compound()["values"] = new nbtpp2::tags::TagByteArray{values};
+
+    auto writer = nbtpp2::BufferWriter{};
+    {
+        nbtpp2::ParallelGzWriter deflater{writer, nbtpp2::WriteOptions{}, 4, 4096};
+        nbtpp2::write_tag_id(nbtpp2::TagType::TagCompound, deflater);
+        nbtpp2::write_string("parallel", deflater, nbtpp2::Endianness::Big);
+        file.get_root_tag().write(deflater, nbtpp2::Endianness::Big);
+        deflater.finish();
+        REQUIRE_THROWS_AS(deflater.write("x", 1), std::runtime_error);
+    }
+    auto read = nbtpp2::NbtFile{writer.data(), writer.size(), nbtpp2::Endianness::Big};
+    REQUIRE(read.get_root_tag_compound()["values"]->as<nbtpp2::tags::TagByteArray>().value == values);
+
+    file.set_write_threads(4);
+    file.write("test.parallel.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Gzip);
+    auto gz = nbtpp2::NbtFile{"test.parallel.nbt", nbtpp2::Endianness::Big};
+    REQUIRE(gz.get_root_tag_compound()["values"]->as<nbtpp2::tags::TagByteArray>().value == values);
+
+    // Invalid options are rejected up front, and an unfinished writer is simply dropped
+    auto invalid = nbtpp2::WriteOptions{};
+    invalid.mem_level = 0;
+    auto unused = nbtpp2::BufferWriter{};
+    REQUIRE_THROWS_AS(nbtpp2::ParallelGzWriter(unused, invalid, 2), std::runtime_error);
+    file.set_write_threads(2);
+    REQUIRE_THROWS_AS(file.write(unused, nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Gzip, invalid),
+                      std::runtime_error);
+    {
+        nbtpp2::ParallelGzWriter abandoned{unused, nbtpp2::WriteOptions{}, 2, 4096};
+        file.get_root_tag().write(abandoned, nbtpp2::Endianness::Big);
+    }
+
+    // Errors of the workers are rethrown in order, and the writer can still be destroyed afterwards
+    {
+        nbtpp2::ParallelGzWriter failing{unused, nbtpp2::WriteOptions{}, 2, 4096};
+        allocating_thread = std::this_thread::get_id();
+        fail_other_thread_allocations = true;
+        REQUIRE_THROWS_AS(file.get_root_tag().write(failing, nbtpp2::Endianness::Big), std::bad_alloc);
+        REQUIRE_THROWS_AS(failing.finish(), std::bad_alloc);
+        fail_other_thread_allocations = false;
+    }
+}
+
+TEST_CASE("Zstandard and LZ4", "[compression]")
+{
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+
+    auto round_trip = [&](nbtpp2::NbtFile::Compression compression, const std::string &path)
+    {
+        file.write(path, nbtpp2::Endianness::Big, compression);
+        auto read = nbtpp2::NbtFile{path, nbtpp2::Endianness::Big};
+        REQUIRE(read.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+
+        auto writer = nbtpp2::BufferWriter{};
+        file.write(writer, nbtpp2::Endianness::Big, compression);
+        auto buffered = nbtpp2::NbtFile{writer.data(), writer.size(), nbtpp2::Endianness::Big};
+        REQUIRE(buffered.root_name == "Level");
+    };
+
+#ifdef NBTPP2_WITH_ZSTD
+    round_trip(nbtpp2::NbtFile::Compression::Zstd, "test.zst.nbt");
+#else
+    std::remove("test.zst.nbt");
+    REQUIRE_THROWS(round_trip(nbtpp2::NbtFile::Compression::Zstd, "test.zst.nbt"));
+    REQUIRE(fopen("test.zst.nbt", "rb") == nullptr);
+#endif
+#ifdef NBTPP2_WITH_LZ4
+    round_trip(nbtpp2::NbtFile::Compression::Lz4, "test.lz4.nbt");
+#else
+    std::remove("test.lz4.nbt");
+    REQUIRE_THROWS(round_trip(nbtpp2::NbtFile::Compression::Lz4, "test.lz4.nbt"));
+    REQUIRE(fopen("test.lz4.nbt", "rb") == nullptr);
+#endif
+}
+
+TEST_CASE("Write options", "[compression]")
+{
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+
+    auto fast = nbtpp2::WriteOptions{};
+    fast.level = 1;
+    fast.strategy = nbtpp2::DeflateStrategy::Rle;
+    auto best = nbtpp2::WriteOptions{};
+    best.level = 9;
+    best.window_bits = 10;
+    best.mem_level = 9;
+
+    for (auto compression : {nbtpp2::NbtFile::Compression::Gzip, nbtpp2::NbtFile::Compression::Zlib}) {
+        auto fast_writer = nbtpp2::BufferWriter{};
+        file.write(fast_writer, nbtpp2::Endianness::Big, compression, fast);
+        auto best_writer = nbtpp2::BufferWriter{};
+        file.write(best_writer, nbtpp2::Endianness::Big, compression, best);
+        REQUIRE(best_writer.size() < fast_writer.size());
+
+        auto read = nbtpp2::NbtFile{best_writer.data(), best_writer.size(), nbtpp2::Endianness::Big};
+        REQUIRE(read.root_name == "Level");
+    }
+
+    auto invalid = nbtpp2::WriteOptions{};
+    invalid.mem_level = 0;
+    REQUIRE_THROWS(file.write("test.invalid.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Zlib, invalid));
+
+    auto sink = nbtpp2::BufferWriter{};
+    auto bad_level = nbtpp2::WriteOptions{};
+    bad_level.level = 10;
+    REQUIRE_THROWS(nbtpp2::ZlibWriter{sink, bad_level});
+    auto bad_window = nbtpp2::WriteOptions{};
+    bad_window.window_bits = 8;
+    REQUIRE_THROWS(nbtpp2::ZlibWriter{sink, bad_window, true});
+}
+
+TEST_CASE("Region file read", "[region]")
+{
+    auto chunk = nbtpp2::NbtFile{"Chunk"};
+    chunk.get_root_tag_compound()["xPos"] = new nbtpp2::tags::TagInt{1};
+
+    auto region = std::vector<char>(4 * nbtpp2::REGION_SECTOR_SIZE, 0);
+    auto put_u32 = [&](std::size_t at, std::uint32_t value)
+    {
+        for (std::size_t i = 0; i < 4; ++i) {
+            region[at + i] = static_cast<char>((value >> (24 - i * 8)) & 0xFF);
+        }
+    };
+    auto put_chunk = [&](std::size_t index, std::uint32_t sector, nbtpp2::NbtFile::Compression compression, char id)
+    {
+        auto writer = nbtpp2::BufferWriter{};
+        chunk.write(writer, nbtpp2::Endianness::Big, compression);
+        put_u32(index * 4, sector << 8u | 1u);
+        put_u32(nbtpp2::REGION_SECTOR_SIZE + index * 4, 1234);
+        put_u32(sector * nbtpp2::REGION_SECTOR_SIZE, static_cast<std::uint32_t>(writer.size() + 1));
+        region[sector * nbtpp2::REGION_SECTOR_SIZE + 4] = id;
+        std::copy(writer.data(), writer.data() + writer.size(), region.begin() + sector * nbtpp2::REGION_SECTOR_SIZE + 5);
+    };
+    put_chunk(0, 2, nbtpp2::NbtFile::Compression::Zlib, 2);
+    put_chunk(33, 3, nbtpp2::NbtFile::Compression::None, 3);
+
+    auto out = std::ofstream{"r.0.0.mca", std::ios_base::binary};
+    out.write(region.data(), region.size());
+    out.close();
+
+    nbtpp2::RegionFile file{"r.0.0.mca"};
+    REQUIRE(file.has_chunk(0, 0));
+    REQUIRE(file.has_chunk(1, 1));
+    REQUIRE(file.has_chunk(33, -31));
+    REQUIRE_FALSE(file.has_chunk(1, 0));
+    REQUIRE(file.timestamp(0, 0) == 1234);
+    REQUIRE(file.read_chunk(0, 0).get_root_tag_compound()["xPos"]->as<nbtpp2::tags::TagInt>().value == 1);
+    REQUIRE(file.read_chunk(1, 1).root_name == "Chunk");
+    REQUIRE_THROWS(file.read_chunk(1, 0));
+}
+
+TEST_CASE("Region file write", "[region]")
+{
+    std::remove("r.1.-1.mca");
+    auto chunk = nbtpp2::NbtFile{"Chunk"};
+    auto make_chunk = [&](int x, std::size_t payload)
+    {
+        delete chunk.get_root_tag_compound()["xPos"];
+        chunk.get_root_tag_compound()["xPos"] = new nbtpp2::tags::TagInt{x};
+        delete chunk.get_root_tag_compound()["Data"];
+        chunk.get_root_tag_compound()["Data"] = new nbtpp2::tags::TagByteArray{
+            random_t_array<std::int8_t, std::uint8_t, UINT8_MAX>(payload, 0)
+        };
+    };
+
+    {
+        nbtpp2::RegionWriter writer{"r.1.-1.mca"};
+        for (int x = 0; x < 4; ++x) {
+            make_chunk(x, 6000);
+            writer.write_chunk(x, 0, chunk);
+        }
+        REQUIRE(writer.sector_count() == 2 + 4 * 2);
+
+        // New sectors are allocated before the old ones are released, so a replaced chunk's sectors are reused
+        // by the next write rather than its own
+        make_chunk(10, 100);
+        writer.write_chunk(1, 0, chunk);
+        REQUIRE(writer.sector_count() == 11);
+        REQUIRE(writer.free_sector_count() == 2);
+        make_chunk(11, 100);
+        writer.write_chunk(2, 0, chunk, nbtpp2::RegionFile::ChunkCompression::None);
+        REQUIRE(writer.sector_count() == 11);
+        REQUIRE(writer.free_sector_count() == 3);
+
+        writer.remove_chunk(3, 0);
+        REQUIRE(writer.free_sector_count() == 5);
+
+        // Too big for 255 sectors, goes to c.32.-32.mcc
+        make_chunk(12, 1100000);
+        writer.write_chunk(0, 0, chunk, nbtpp2::RegionFile::ChunkCompression::None);
+    }
+    {
+        nbtpp2::RegionWriter writer{"r.1.-1.mca"};
+        REQUIRE(writer.free_sector_count() == 6);
+        writer.compact();
+        REQUIRE(writer.free_sector_count() == 0);
+        REQUIRE(writer.sector_count() == 2 + 3);
+    }
+
+    nbtpp2::RegionFile region{"r.1.-1.mca"};
+    REQUIRE(region.read_chunk(0, 0).get_root_tag_compound()["xPos"]->as<nbtpp2::tags::TagInt>().value == 12);
+    REQUIRE(region.read_chunk(1, 0).get_root_tag_compound()["xPos"]->as<nbtpp2::tags::TagInt>().value == 10);
+    REQUIRE(region.read_chunk(2, 0).get_root_tag_compound()["xPos"]->as<nbtpp2::tags::TagInt>().value == 11);
+    REQUIRE_FALSE(region.has_chunk(3, 0));
+    REQUIRE(region.timestamp(1, 0) > 0);
+
+    // External chunks are renamed into place, and deleted once the region no longer refers to them
+    auto exists = [](const char *path) { return std::ifstream{path}.good(); };
+    REQUIRE(exists("c.32.-32.mcc"));
+    REQUIRE_FALSE(exists("c.32.-32.mcc.tmp"));
+    {
+        nbtpp2::RegionWriter writer{"r.1.-1.mca"};
+        make_chunk(13, 100);
+        writer.write_chunk(0, 0, chunk);
+        REQUIRE_FALSE(exists("c.32.-32.mcc"));
+        make_chunk(14, 1100000);
+        writer.write_chunk(0, 0, chunk, nbtpp2::RegionFile::ChunkCompression::None);
+        REQUIRE(exists("c.32.-32.mcc"));
+        writer.remove_chunk(0, 0);
+        REQUIRE_FALSE(exists("c.32.-32.mcc"));
+    }
+}
+
+TEST_CASE("Parallel region decoding", "[region]")
+{
+    for (auto directory : {"test_world", "test_world/region", "test_world/DIM-1", "test_world/DIM-1/region"}) {
+        REQUIRE(make_directory(directory));
+    }
+    const std::vector<std::string> paths{"test_world/region/r.0.0.mca", "test_world/region/r.1.0.mca",
+                                         "test_world/DIM-1/region/r.0.0.mca"};
+    for (std::size_t i = 0; i < paths.size(); ++i) {
+        std::remove(paths[i].c_str());
+        nbtpp2::RegionWriter writer{paths[i]};
+        for (int z = 0; z < 32; ++z) {
+            for (int x = 0; x < 4; ++x) {
+                auto chunk = nbtpp2::NbtFile{"Chunk"};
+                chunk.get_root_tag_compound()["id"] = new nbtpp2::tags::TagInt{static_cast<std::int32_t>(i * 1024 + z * 32 + x)};
+                writer.write_chunk(x, z, chunk);
+            }
+        }
+    }
+
+    REQUIRE(nbtpp2::find_region_files("test_world") == std::vector<std::string>{
+        "test_world/region/r.0.0.mca", "test_world/region/r.1.0.mca", "test_world/DIM-1/region/r.0.0.mca"
+    });
+
+    // Catch assertions are not thread-safe, so the callback only records what it got
+    std::mutex mutex;
+    std::vector<std::int32_t> ids;
+    std::size_t mismatches = 0;
+    nbtpp2::decode_world("test_world", [&](const std::string &path, int x, int z, nbtpp2::NbtFile &chunk)
+    {
+        auto id = chunk.get_root_tag_compound()["id"]->as<nbtpp2::tags::TagInt>().value;
+        auto i = std::find(paths.begin(), paths.end(), path) - paths.begin();
+        std::lock_guard<std::mutex> lock{mutex};
+        if (id != i * 1024 + z * 32 + x) ++mismatches;
+        ids.push_back(id);
+    }, 4);
+    REQUIRE(mismatches == 0);
+    REQUIRE(ids.size() == 3 * 32 * 4);
+
+    REQUIRE_THROWS_AS(nbtpp2::decode_regions({"test_world/region/r.0.0.mca"}, [](const std::string &, int, int, nbtpp2::NbtFile &)
+    {
+        throw std::runtime_error("callback failed");
+    }, 2), std::runtime_error);
+}
+
+TEST_CASE("Arena read", "[arena]")
+{
+    auto options = nbtpp2::ReadOptions{};
+    options.arena = true;
+
+    auto copy = nbtpp2::NbtFile{};
+    {
+        auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+        REQUIRE(file.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+
+        // Tags from the heap and from the arena can be mixed in one tree
+        delete file.get_root_tag_compound()["intTest"];
+        file.get_root_tag_compound()["intTest"] = new nbtpp2::tags::TagInt{42};
+        copy = file;
+    }
+    // The copy keeps the arena alive
+    REQUIRE(copy.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 42);
+    REQUIRE(copy.get_root_tag().as<nbtpp2::tags::TagCompound>()
+                .traverse({"nested compound test", "egg", "name"})->as<nbtpp2::tags::TagString>().value == "Eggbert");
+
+    // Assigning over an arena-backed file frees its tree before its arena
+    auto reassigned = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    for (int i = 0; i < 2; ++i) {
+        reassigned = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+        REQUIRE(reassigned.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+    }
+    reassigned = copy;
+    REQUIRE(reassigned.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 42);
+
+    nbtpp2::Arena arena{256};
+    {
+        nbtpp2::ArenaScope scope{&arena};
+        REQUIRE(nbtpp2::Arena::current() == &arena);
+        for (int i = 0; i < 100; ++i) {
+            delete new nbtpp2::tags::TagLong{i};
+        }
+        delete new nbtpp2::tags::TagByteArray{std::vector<std::int8_t>(1000)};
+    }
+    REQUIRE(nbtpp2::Arena::current() == nullptr);
+    REQUIRE(arena.block_count() > 1);
+    REQUIRE(arena.bytes_used() >= 100 * sizeof(nbtpp2::tags::TagLong));
+
+    // Heap tags take no extra memory, and are told apart from arena tags by address
+    auto heap_tag = std::unique_ptr<nbtpp2::tags::TagLong>{new nbtpp2::tags::TagLong{1}};
+    REQUIRE_FALSE(nbtpp2::Arena::owns(heap_tag.get()));
+    auto used = arena.bytes_used();
+    nbtpp2::Tag *arena_tag;
+    {
+        nbtpp2::ArenaScope scope{&arena};
+        arena_tag = new nbtpp2::tags::TagLong{2};
+    }
+    REQUIRE(arena.bytes_used() - used == sizeof(nbtpp2::tags::TagLong));
+    REQUIRE(nbtpp2::Arena::owns(arena_tag));
+
+    // Other threads tell heap tags from arena tags without locking, while the arena is alive
+    std::atomic<int> misjudged{0};
+    auto threads = std::vector<std::thread>{};
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([&] {
+            for (int i = 0; i < 10000; ++i) {
+                auto tag = new nbtpp2::tags::TagLong{i};
+                if (nbtpp2::Arena::owns(tag) || !nbtpp2::Arena::owns(arena_tag)) ++misjudged;
+                delete tag;
+            }
+        });
+    }
+    for (auto &thread : threads) thread.join();
+    REQUIRE(misjudged == 0);
+    delete arena_tag;
+}
+
+TEST_CASE("Compound map", "[tag_compound]")
+{
+    using Order = nbtpp2::CompoundMap::Order;
+
+    auto map = nbtpp2::CompoundMap{{{"b", nullptr}, {"a", nullptr}, {"b", nullptr}}, Order::Insertion};
+    REQUIRE(map.size() == 2);
+    REQUIRE(map.begin()->first == "b");
+
+    // Grow past the hash index threshold, inserting in reverse
+    auto file = nbtpp2::NbtFile{"compound"};
+    auto &root = file.get_root_tag_compound();
+    for (int i = 99; i >= 0; --i) {
+        root[std::to_string(i)] = new nbtpp2::tags::TagInt{i};
+    }
+    REQUIRE(root.size() == 100);
+    REQUIRE(root.begin()->first == "0");
+    for (int i = 0; i < 100; ++i) {
+        REQUIRE(root.at(std::to_string(i))->as<nbtpp2::tags::TagInt>().value == i);
+    }
+    REQUIRE(root.find("100") == root.end());
+    REQUIRE_THROWS_AS(root.at("100"), std::out_of_range);
+
+    delete root.at("50");
+    REQUIRE(root.erase("50") == 1);
+    REQUIRE(root.count("50") == 0);
+    REQUIRE(root.at("51")->as<nbtpp2::tags::TagInt>().value == 51);
+    REQUIRE_FALSE(root.emplace("51", nullptr).second);
+
+    root.set_order(Order::Insertion);
+    root["last"] = new nbtpp2::tags::TagString{"end"};
+    REQUIRE(std::prev(root.end())->first == "last");
+
+    auto writer = nbtpp2::BufferWriter{};
+    file.write(writer, nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::None);
+    auto read = nbtpp2::NbtFile{writer.data(), writer.size(), nbtpp2::Endianness::Big};
+    REQUIRE(read.get_root_tag_compound().size() == 100);
+    REQUIRE(read.get_root_tag_compound()["99"]->as<nbtpp2::tags::TagInt>().value == 99);
+    REQUIRE(read.get_root_tag_compound()["last"]->as<nbtpp2::tags::TagString>().value == "end");
+
+    // Reading sorts and indexes a compound once at its end, and a repeated name keeps the last tag
+    auto raw = nbtpp2::BufferWriter{};
+    nbtpp2::write_tag_id(nbtpp2::TagType::TagCompound, raw);
+    nbtpp2::write_string("", raw, nbtpp2::Endianness::Big);
+    for (int i = 99; i >= 0; --i) {
+        nbtpp2::write_tag_id(nbtpp2::TagType::TagInt, raw);
+        nbtpp2::write_string(std::to_string(i % 60), raw, nbtpp2::Endianness::Big);
+        nbtpp2::tags::TagInt{i}.write(raw, nbtpp2::Endianness::Big);
+    }
+    nbtpp2::write_tag_id(nbtpp2::TagType::TagEnd, raw);
+    auto repeated = nbtpp2::NbtFile{raw.data(), raw.size(), nbtpp2::Endianness::Big};
+    auto &repeated_root = repeated.get_root_tag_compound();
+    REQUIRE(repeated_root.size() == 60);
+    REQUIRE(repeated_root.begin()->first == "0");
+    REQUIRE(repeated_root["10"]->as<nbtpp2::tags::TagInt>().value == 10);
+    REQUIRE(repeated_root["59"]->as<nbtpp2::tags::TagInt>().value == 59);
+    REQUIRE(repeated_root.find("60") == repeated_root.end());
+}
+
+TEST_CASE("Interned keys", "[key]")
+{
+    auto id = nbtpp2::Key{"id"};
+    REQUIRE(id == nbtpp2::Key{std::string{"id"}});
+    REQUIRE(id != nbtpp2::Key{"Pos"});
+    REQUIRE(&id.str() == &nbtpp2::Key{"id"}.str());
+    REQUIRE(nbtpp2::Key{}.str().empty());
+
+    auto first = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+    auto count = nbtpp2::interned_key_count();
+    // Reading the same names again does not add to the pool
+    auto second = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+    REQUIRE(nbtpp2::interned_key_count() == count);
+    REQUIRE(first.get_root_tag_compound().begin()->first == second.get_root_tag_compound().begin()->first);
+
+    auto int_test = nbtpp2::Key{"intTest"};
+    REQUIRE(second.get_root_tag_compound().at(int_test)->as<nbtpp2::tags::TagInt>().value == 2147483647);
+    REQUIRE(second.get_root_tag_compound().count(std::string{"intTest"}) == 1);
+
+    // Keys work like strings where callers used std::map's string keys
+    REQUIRE(int_test.size() == 7);
+    REQUIRE(std::strcmp(int_test.c_str(), "intTest") == 0);
+    REQUIRE(std::string(int_test.begin(), int_test.end()) == "intTest");
+    REQUIRE("no tag " + int_test == "no tag intTest");
+    REQUIRE(int_test + std::string{"!"} == "intTest!");
+    std::ostringstream stream;
+    stream << int_test;
+    REQUIRE(stream.str() == "intTest");
+    REQUIRE(nbtpp2::interned_key_bytes() >= int_test.size());
+}
+
+TEST_CASE("Typed number lists", "[tag_list]")
+{
+    auto file = nbtpp2::NbtFile{"entity"};
+    file.get_root_tag_compound()["Pos"] = new nbtpp2::tags::TagList{{
+        new nbtpp2::tags::TagDouble{1.5}, new nbtpp2::tags::TagDouble{-64.0}, new nbtpp2::tags::TagDouble{1e10},
+    }};
+    file.get_root_tag_compound()["Ids"] = new nbtpp2::tags::TagIntList{{1, -2, 300000}};
+    file.get_root_tag_compound()["Empty"] = new nbtpp2::tags::TagList{{}};
+
+    for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+        auto writer = nbtpp2::BufferWriter{};
+        file.write(writer, endianness, nbtpp2::NbtFile::Compression::None);
+
+        // Typed lists are written like TagLists, so they read back as plain TagLists too
+        auto plain = nbtpp2::NbtFile{writer.data(), writer.size(), endianness};
+        auto &ids = plain.get_root_tag_compound()["Ids"]->as<nbtpp2::tags::TagList>();
+        REQUIRE(ids.value.size() == 3);
+        REQUIRE(ids.value[2]->as<nbtpp2::tags::TagInt>().value == 300000);
+
+        auto options = nbtpp2::ReadOptions{};
+        options.typed_lists = true;
+        auto typed = nbtpp2::NbtFile{writer.data(), writer.size(), endianness, nbtpp2::NbtFile::Compression::Detect, options};
+        auto &pos = typed.get_root_tag_compound()["Pos"]->as<nbtpp2::tags::TagDoubleList>();
+        REQUIRE(pos.value == std::vector<double>{1.5, -64.0, 1e10});
+        REQUIRE(pos.identify() == nbtpp2::TagType::TagList);
+        REQUIRE(typed.get_root_tag_compound()["Ids"]->as<nbtpp2::tags::TagIntList>().value
+                    == std::vector<std::int32_t>{1, -2, 300000});
+        REQUIRE(typed.get_root_tag_compound()["Empty"]->as<nbtpp2::tags::TagList>().value.empty());
+    }
+
+    // Traversing into a typed list turns it into a TagList
+    auto options = nbtpp2::ReadOptions{};
+    options.typed_lists = true;
+    auto big = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    auto &root = big.get_root_tag().as<nbtpp2::tags::TagCompound>();
+    REQUIRE_THROWS_AS(root.value["listTest (long)"]->as<nbtpp2::tags::TagList>(), std::runtime_error);
+    REQUIRE(root.traverse({"listTest (long)", "0"})->as<nbtpp2::tags::TagLong>().value == 11);
+    REQUIRE(root.value["listTest (long)"]->as<nbtpp2::tags::TagList>().value.size() == 5);
+    auto nested = nbtpp2::tags::TagList{{new nbtpp2::tags::TagIntList{{4, 5}}}};
+    REQUIRE(nested.traverse({"0", "1"})->as<nbtpp2::tags::TagInt>().value == 5);
+}
+
+TEST_CASE("Lazy read", "[lazy]")
+{
+    auto options = nbtpp2::ReadOptions{};
+    options.lazy = true;
+
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    auto &root = file.get_root_tag_compound();
+    auto raw = root.raw_entries();
+    auto lazy_count = std::count_if(raw.begin(), raw.end(), [](const nbtpp2::CompoundMap::value_type &entry)
+    {
+        return entry.second->is_lazy();
+    });
+    // The byte array, the two lists and the nested compound
+    REQUIRE(lazy_count == 4);
+
+    auto &nested = root["nested compound test"]->as<nbtpp2::tags::TagCompound>();
+    REQUIRE_FALSE(root.raw_entries()[root.find("nested compound test") - root.begin()].second->is_lazy());
+    REQUIRE(nested.value.raw_entries()[0].second->is_lazy());
+    REQUIRE(file.get_root_tag().as<nbtpp2::tags::TagCompound>()
+                .traverse({"nested compound test", "ham", "value"})->as<nbtpp2::tags::TagFloat>().value == 0.75f);
+
+    // Unparsed entries are copied as-is (keeping their original order of entries), and parsed when the endianness
+    // changes; either way the result reads back the same as an eagerly read file written out
+    auto eager = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+    for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+        auto lazy_out = nbtpp2::BufferWriter{};
+        auto untouched = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+        untouched.write(lazy_out, endianness, nbtpp2::NbtFile::Compression::None);
+        auto rewritten_out = nbtpp2::BufferWriter{};
+        nbtpp2::NbtFile{lazy_out.data(), lazy_out.size(), endianness}.write(rewritten_out, endianness);
+        auto eager_out = nbtpp2::BufferWriter{};
+        eager.write(eager_out, endianness, nbtpp2::NbtFile::Compression::None);
+        REQUIRE(rewritten_out.buffer() == eager_out.buffer());
+    }
+
+    // Deleting a tag and replacing it, as with a std::map, never touches the deleted tag
+    delete root["listTest (long)"];
+    root["listTest (long)"] = new nbtpp2::tags::TagInt{1};
+    delete root["listTest (long)"];
+    root["listTest (long)"] = new nbtpp2::tags::TagInt{2};
+    REQUIRE(root["listTest (long)"]->as<nbtpp2::tags::TagInt>().value == 2);
+
+    // Iterating parses everything
+    for (auto &entry : root) {
+        REQUIRE_FALSE(entry.second->is_lazy());
+    }
+}
+
+TEST_CASE("Visitor", "[visitor]")
+{
+    struct Collector: nbtpp2::NbtVisitor
+    {
+        std::vector<std::string> events;
+        std::size_t depth = 0;
+        std::size_t max_depth = 0;
+        std::int32_t int_test = 0;
+        std::size_t byte_array_size = 0;
+
+        void begin_compound(const std::string &name) override
+        {
+            events.push_back("{" + name);
+            max_depth = std::max(max_depth, ++depth);
+        }
+
+        void end_compound() override
+        {
+            events.emplace_back("}");
+            --depth;
+        }
+
+        void begin_list(const std::string &name, nbtpp2::TagType element_type, std::int32_t length) override
+        {
+            events.push_back("[" + name + ":" + nbtpp2::tag_type_to_string(element_type) + ":" + std::to_string(length));
+        }
+
+        void value(const std::string &name, std::int32_t value) override
+        {
+            if (name == "intTest") int_test = value;
+        }
+
+        void value(const std::string &name, const std::string &value) override
+        {
+            events.push_back(name + "=" + value);
+        }
+
+        void array(const std::string &, const std::int8_t *, std::size_t size) override
+        {
+            byte_array_size = size;
+        }
+    };
+
+    Collector collector;
+    nbtpp2::NbtFile::visit("bigtest.nbt", nbtpp2::Endianness::Big, collector);
+    REQUIRE(collector.events.front() == "{Level");
+    REQUIRE(collector.events.back() == "}");
+    REQUIRE(collector.depth == 0);
+    REQUIRE(collector.max_depth == 3);
+    REQUIRE(collector.int_test == 2147483647);
+    REQUIRE(collector.byte_array_size == 1000);
+    REQUIRE(std::find(collector.events.begin(), collector.events.end(), "name=Eggbert") != collector.events.end());
+    REQUIRE(std::find(collector.events.begin(), collector.events.end(), "[listTest (long):TAG_Long:5")
+                != collector.events.end());
+
+    // The same tree visited in either endianness gives the same events
+    auto big = uncompressed_bigtest(nbtpp2::Endianness::Big);
+    auto big_reader = nbtpp2::BufferReader{big};
+    Collector big_collector;
+    nbtpp2::visit(big_reader, nbtpp2::Endianness::Big, big_collector);
+    auto little = uncompressed_bigtest(nbtpp2::Endianness::Little);
+    auto little_reader = nbtpp2::BufferReader{little};
+    Collector little_collector;
+    nbtpp2::visit(little_reader, nbtpp2::Endianness::Little, little_collector);
+    REQUIRE(little_collector.events == big_collector.events);
+    REQUIRE(little_collector.int_test == 2147483647);
+
+    // Lists nested deeper than skip_tag() allows are rejected instead of overflowing the stack
+    auto nested = std::vector<char>{static_cast<char>(nbtpp2::TagType::TagList), 0, 0};
+    for (std::size_t i = 0; i <= nbtpp2::MAX_SKIP_DEPTH; ++i) {
+        nested.insert(nested.end(), {static_cast<char>(nbtpp2::TagType::TagList), 0, 0, 0, 1});
+    }
+    auto nested_reader = nbtpp2::BufferReader{nested};
+    Collector deep;
+    REQUIRE_THROWS_WITH(nbtpp2::visit(nested_reader, nbtpp2::Endianness::Big, deep), "tags nested too deeply to visit");
+}
+
+TEST_CASE("Cursor", "[cursor]")
+{
+    auto inflated = inflated_bigtest();
+    auto reader = nbtpp2::BufferReader{inflated};
+
+    nbtpp2::NbtCursor cursor{reader, nbtpp2::Endianness::Big};
+    REQUIRE(cursor.next());
+    REQUIRE(cursor.type() == nbtpp2::TagType::TagCompound);
+    REQUIRE(cursor.name() == "Level");
+    cursor.enter();
+
+    std::int32_t int_test = 0;
+    std::string egg_name;
+    std::vector<std::int64_t> longs;
+    std::size_t entries = 0;
+    while (cursor.next()) {
+        ++entries;
+        if (cursor.name() == "intTest") {
+            REQUIRE_THROWS_AS(cursor.read_long(), std::runtime_error);
+            int_test = cursor.read_int();
+        }
+        else if (cursor.name() == "nested compound test") {
+            cursor.enter();
+            while (cursor.next()) {
+                if (cursor.name() != "egg") continue;
+                cursor.enter();
+                while (cursor.next()) {
+                    if (cursor.name() == "name") egg_name = cursor.read_string();
+                }
+                cursor.exit();
+                // Leave the rest of the compound unread
+                break;
+            }
+            cursor.exit();
+            REQUIRE(cursor.depth() == 1);
+        }
+        else if (cursor.name() == "listTest (long)") {
+            cursor.enter();
+            REQUIRE(cursor.remaining() == 5);
+            while (cursor.next()) {
+                longs.push_back(cursor.read_long());
+            }
+            cursor.exit();
+        }
+    }
+    cursor.exit();
+    REQUIRE_FALSE(cursor.next());
+    REQUIRE(reader.position() == reader.size());
+
+    REQUIRE(entries == 11);
+    REQUIRE(int_test == 2147483647);
+    REQUIRE(egg_name == "Eggbert");
+    REQUIRE(longs == std::vector<std::int64_t>{11, 12, 13, 14, 15});
+
+    auto little = uncompressed_bigtest(nbtpp2::Endianness::Little);
+    auto little_reader = nbtpp2::BufferReader{little};
+    nbtpp2::NbtCursor little_cursor{little_reader, nbtpp2::Endianness::Little};
+    REQUIRE(little_cursor.next());
+    REQUIRE(little_cursor.name() == "Level");
+    little_cursor.enter();
+    while (little_cursor.next()) {
+        if (little_cursor.name() == "intTest") REQUIRE(little_cursor.read_int() == 2147483647);
+        else if (little_cursor.name() == "listTest (long)") {
+            little_cursor.enter();
+            REQUIRE(little_cursor.next());
+            REQUIRE(little_cursor.read_long() == 11);
+            little_cursor.exit();
+        }
+    }
+    little_cursor.exit();
+    REQUIRE(little_reader.position() == little_reader.size());
+}
+
+TEST_CASE("Skip tag", "[skip]")
+{
+    auto inflated = inflated_bigtest();
+
+    auto reader = nbtpp2::BufferReader{inflated};
+    REQUIRE(nbtpp2::read_tag_id(reader) == nbtpp2::TagType::TagCompound);
+    REQUIRE(nbtpp2::read_string(reader, nbtpp2::Endianness::Big) == "Level");
+    nbtpp2::skip_tag(nbtpp2::TagType::TagCompound, reader, nbtpp2::Endianness::Big);
+    REQUIRE(reader.position() == reader.size());
+
+    // Files are skipped by seeking
+    auto file = std::fopen("skip_tag.nbt", "w+b");
+    REQUIRE(file != nullptr);
+    std::fwrite(inflated.data(), 1, inflated.size(), file);
+    std::rewind(file);
+    auto file_reader = nbtpp2::FileReader{file};
+    REQUIRE(nbtpp2::read_tag_id(file_reader) == nbtpp2::TagType::TagCompound);
+    nbtpp2::read_string(file_reader, nbtpp2::Endianness::Big);
+    nbtpp2::skip_tag(nbtpp2::TagType::TagCompound, file_reader, nbtpp2::Endianness::Big);
+    REQUIRE(static_cast<std::size_t>(std::ftell(file)) == inflated.size());
+    std::fclose(file);
+    std::remove("skip_tag.nbt");
+
+    // Lists nested deeper than the stack allows
+    auto nested = std::vector<char>{};
+    for (std::size_t i = 0; i <= nbtpp2::MAX_SKIP_DEPTH; ++i) {
+        nested.insert(nested.end(), {static_cast<char>(nbtpp2::TagType::TagList), 0, 0, 0, 1});
+    }
+    auto nested_reader = nbtpp2::BufferReader{nested};
+    REQUIRE_THROWS_AS(nbtpp2::skip_tag(nbtpp2::TagType::TagList, nested_reader, nbtpp2::Endianness::Big),
+                      std::runtime_error);
+
+    // An array running past the end of the buffer
+    const char truncated[] = {0, 0, 0, 16, 1, 2};
+    auto truncated_reader = nbtpp2::BufferReader{truncated, sizeof(truncated)};
+    REQUIRE_THROWS_AS(nbtpp2::skip_tag(nbtpp2::TagType::TagIntArray, truncated_reader, nbtpp2::Endianness::Big),
+                      std::runtime_error);
+}
+
+TEST_CASE("Projection", "[projection]")
+{
+    auto options = nbtpp2::ReadOptions{};
+    options.paths = {"intTest", "nested compound test.egg.name", "listTest (compound)[*].name", "listTest (long)",
+                     "missing.entry"};
+
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    auto &root = file.get_root_tag_compound();
+    REQUIRE(root.size() == 4);
+    REQUIRE(root["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+    REQUIRE(root["listTest (long)"]->as<nbtpp2::tags::TagList>().value.size() == 5);
+
+    auto &nested = root["nested compound test"]->as<nbtpp2::tags::TagCompound>().value;
+    REQUIRE(nested.size() == 1);
+    auto &egg = nested["egg"]->as<nbtpp2::tags::TagCompound>().value;
+    REQUIRE(egg.size() == 1);
+    REQUIRE(egg["name"]->as<nbtpp2::tags::TagString>().value == "Eggbert");
+
+    auto &compounds = root["listTest (compound)"]->as<nbtpp2::tags::TagList>().value;
+    REQUIRE(compounds.size() == 2);
+    for (auto compound : compounds) {
+        REQUIRE(compound->as<nbtpp2::tags::TagCompound>().value.size() == 1);
+        REQUIRE(compound->as<nbtpp2::tags::TagCompound>().value.count("name") == 1);
+    }
+
+    // [*] can be left out, and projections combine with lazy reading
+    options.paths = {"listTest (compound).created-on", "nested compound test"};
+    options.lazy = true;
+    auto lazy = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+    auto &lazy_root = lazy.get_root_tag_compound();
+    REQUIRE(lazy_root.size() == 2);
+    // Only the entry selected as a whole is left unparsed
+    auto raw = lazy_root.raw_entries();
+    REQUIRE(std::count_if(raw.begin(), raw.end(), [](const nbtpp2::CompoundMap::value_type &entry)
+    {
+        return entry.second->is_lazy();
+    }) == 1);
+    REQUIRE(lazy.get_root_tag().as<nbtpp2::tags::TagCompound>()
+                .traverse({"nested compound test", "ham", "value"})->as<nbtpp2::tags::TagFloat>().value == 0.75f);
+    auto &first = lazy_root["listTest (compound)"]->as<nbtpp2::tags::TagList>().value[0]->as<nbtpp2::tags::TagCompound>();
+    REQUIRE(first.value.size() == 1);
+    REQUIRE(first.value["created-on"]->as<nbtpp2::tags::TagLong>().value == 1264099775885);
+
+    REQUIRE_THROWS_AS(nbtpp2::Projection{{"Level..xPos"}}, std::runtime_error);
+    REQUIRE_THROWS_AS(nbtpp2::Projection{{"Level.Sections[0]"}}, std::runtime_error);
+}
+
+TEST_CASE("Byte swap", "[swap]")
+{
+    INFO("implementation: " << nbtpp2::swap_bytes_implementation());
+
+    // Odd lengths and an unaligned start cover both the vector loop and the scalar tail
+    std::vector<std::uint64_t> longs(67);
+    for (std::size_t i = 0; i < longs.size(); ++i) {
+        longs[i] = 0x0102030405060708ull * (i + 1);
+    }
+    auto bytes = std::vector<char>(longs.size() * 8 + 1);
+    std::memcpy(bytes.data() + 1, longs.data(), longs.size() * 8);
+    nbtpp2::swap_bytes(bytes.data() + 1, longs.size(), 8);
+    for (std::size_t i = 0; i < longs.size(); ++i) {
+        std::uint64_t swapped;
+        std::memcpy(&swapped, bytes.data() + 1 + i * 8, 8);
+        REQUIRE(swapped == nbtpp2::reverse_uint(longs[i]));
+    }
+
+    std::vector<std::uint32_t> ints{0x01020304u, 0xA0B0C0D0u, 0xDEADBEEFu, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10};
+    auto swapped_ints = ints;
+    nbtpp2::swap_bytes(swapped_ints.data(), swapped_ints.size(), 4);
+    for (std::size_t i = 0; i < ints.size(); ++i) {
+        REQUIRE(swapped_ints[i] == nbtpp2::reverse_uint(ints[i]));
+    }
+
+    std::vector<std::uint16_t> shorts(35);
+    for (std::size_t i = 0; i < shorts.size(); ++i) {
+        shorts[i] = static_cast<std::uint16_t>(0x0102u * (i + 1));
+    }
+    auto swapped_shorts = shorts;
+    nbtpp2::swap_bytes(swapped_shorts.data(), swapped_shorts.size(), 2);
+    for (std::size_t i = 0; i < shorts.size(); ++i) {
+        REQUIRE(swapped_shorts[i] == static_cast<std::uint16_t>(nbtpp2::reverse_uint(shorts[i])));
+    }
+
+    // Int and long arrays round-trip in either endianness and are stored in it
+    for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+        auto values = std::vector<std::int64_t>{-1, 0, 1, 0x0102030405060708, INT64_MIN, INT64_MAX, 42};
+        auto writer = nbtpp2::BufferWriter{};
+        nbtpp2::tags::TagLongArray{values}.write(writer, endianness);
+        nbtpp2::tags::TagIntArray{{0x01020304, -2}}.write(writer, endianness);
+        // The low byte of values[3], after the length and three longs
+        auto low_byte = endianness == nbtpp2::Endianness::Big ? 4 + 8 * 3 + 7 : 4 + 8 * 3;
+        REQUIRE(writer.data()[low_byte] == 0x08);
+
+        auto reader = nbtpp2::BufferReader{writer.data(), writer.size()};
+        std::unique_ptr<nbtpp2::tags::TagLongArray> longs_read{nbtpp2::tags::TagLongArray::read(reader, endianness)};
+        REQUIRE(longs_read->value == values);
+        std::unique_ptr<nbtpp2::tags::TagIntArray> ints_read{nbtpp2::tags::TagIntArray::read(reader, endianness)};
+        REQUIRE(ints_read->value == std::vector<std::int32_t>{0x01020304, -2});
+    }
+}
+
+TEST_CASE("Compile-time endianness", "[endianness]")
+{
+    auto writer = nbtpp2::BufferWriter{};
+    nbtpp2::write_number<nbtpp2::Endianness::Big, std::int32_t, std::uint32_t>(0x01020304, writer);
+    nbtpp2::write_number<std::int32_t, std::uint32_t>(0x01020304, writer, nbtpp2::Endianness::Little);
+    REQUIRE(std::string(writer.data(), writer.size()) == std::string("\x01\x02\x03\x04\x04\x03\x02\x01", 8));
+
+    auto reader = nbtpp2::BufferReader{writer.data(), writer.size()};
+    REQUIRE(nbtpp2::read_number<std::int32_t, std::uint32_t>(reader, nbtpp2::Endianness::Big) == 0x01020304);
+    REQUIRE((nbtpp2::read_number<nbtpp2::Endianness::Little, std::int32_t, std::uint32_t>(reader)) == 0x01020304);
+
+    // Trees written in one endianness read back the same through the specialised engine
+    auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big};
+    auto big = nbtpp2::BufferWriter{};
+    file.get_root_tag().write(big, nbtpp2::Endianness::Big);
+    auto little = nbtpp2::BufferWriter{};
+    file.get_root_tag().write(little, nbtpp2::Endianness::Little);
+
+    auto little_reader = nbtpp2::BufferReader{little.data(), little.size()};
+    std::unique_ptr<nbtpp2::Tag> tag{
+        nbtpp2::read_tag<nbtpp2::Endianness::Little>(nbtpp2::TagType::TagCompound, little_reader)};
+    auto rewritten = nbtpp2::BufferWriter{};
+    tag->write(rewritten, nbtpp2::Endianness::Big);
+    REQUIRE(little_reader.position() == little.size());
+    REQUIRE(std::string(rewritten.data(), rewritten.size()) == std::string(big.data(), big.size()));
+}
+
+TEST_CASE("Struct binding", "[binding]")
+{
+    auto inflated = inflated_bigtest();
+
+    auto reader = nbtpp2::BufferReader{inflated};
+    BigTest big;
+    nbtpp2::read_struct(reader, nbtpp2::Endianness::Big, big);
+    REQUIRE(reader.position() == reader.size());
+    REQUIRE(big.int_test == 2147483647);
+    REQUIRE(big.long_test == 9223372036854775807);
+    REQUIRE(big.byte_test);
+    REQUIRE(big.nested.egg.name == "Eggbert");
+    REQUIRE(big.nested.ham.value == 0.75f);
+    REQUIRE(big.longs == std::vector<std::int64_t>{11, 12, 13, 14, 15});
+    REQUIRE(big.items.size() == 2);
+    REQUIRE(big.items[0].created_on == 1264099775885);
+
+    // Written structs read back as regular trees, and into the struct again
+    for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+        auto writer = nbtpp2::BufferWriter{};
+        nbtpp2::write_struct(big, writer, endianness, "Level");
+        auto file = nbtpp2::NbtFile{writer.data(), writer.size(), endianness};
+        REQUIRE(file.get_root_tag_compound().size() == 8);
+        REQUIRE(file.get_root_tag().as<nbtpp2::tags::TagCompound>()
+                    .traverse({"nested compound test", "egg", "name"})->as<nbtpp2::tags::TagString>().value == "Eggbert");
+        REQUIRE(file.get_root_tag_compound()["listTest (long)"]->identify() == nbtpp2::TagType::TagList);
+
+        auto struct_reader = nbtpp2::BufferReader{writer.data(), writer.size()};
+        BigTest copy;
+        nbtpp2::read_struct(struct_reader, endianness, copy);
+        REQUIRE(copy.string_test == big.string_test);
+        REQUIRE(copy.double_test == big.double_test);
+        REQUIRE(copy.items[1].name == big.items[1].name);
+        REQUIRE(copy.longs == big.longs);
+    }
+
+    auto mismatched_reader = nbtpp2::BufferReader{inflated};
+    Mismatched mismatched;
+    REQUIRE_THROWS_AS(nbtpp2::read_struct(mismatched_reader, nbtpp2::Endianness::Big, mismatched), std::runtime_error);
+}
+
+TEST_CASE("Serialize", "[serialize]")
+{
+    for (auto lazy : {false, true}) {
+        auto options = nbtpp2::ReadOptions{};
+        options.lazy = lazy;
+        options.typed_lists = true;
+        auto file = nbtpp2::NbtFile{"bigtest.nbt", nbtpp2::Endianness::Big, nbtpp2::NbtFile::Compression::Detect, options};
+        file.get_root_tag_compound()["ints"] = new nbtpp2::tags::TagIntArray{{1, 2, 3}};
+
+        for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+            auto writer = nbtpp2::BufferWriter{};
+            file.write(writer, endianness, nbtpp2::NbtFile::Compression::None);
+            REQUIRE(file.serialized_size() == writer.size());
+            REQUIRE(file.get_root_tag().serialized_size() + 3 + 5 == writer.size());
+
+            auto buffer = file.serialize(endianness);
+            REQUIRE(std::string(buffer.data(), buffer.size()) == std::string(writer.data(), writer.size()));
+
+            auto too_small = std::vector<char>(writer.size() - 1);
+            REQUIRE_THROWS_AS(file.serialize(too_small.data(), too_small.size(), endianness), std::runtime_error);
+        }
+    }
+}
+
+TEST_CASE("Stream writer", "[stream_writer]")
+{
+    auto states = std::vector<std::int64_t>{1, -2, 0x0102030405060708};
+
+    auto file = nbtpp2::NbtFile{"Level"};
+    auto &root = file.get_root_tag_compound();
+    root["BlockStates"] = new nbtpp2::tags::TagLongArray{states};
+    root["Empty"] = new nbtpp2::tags::TagList{{}};
+    root["Pos"] = new nbtpp2::tags::TagList{{new nbtpp2::tags::TagDouble{1.5}, new nbtpp2::tags::TagDouble{-64.0}}};
+    root["Sections"] = new nbtpp2::tags::TagList{{
+        new nbtpp2::tags::TagCompound{{{"Y", new nbtpp2::tags::TagByte{-4}}}},
+        new nbtpp2::tags::TagCompound{{{"Y", new nbtpp2::tags::TagByte{5}}}},
+    }};
+    root["xPos"] = new nbtpp2::tags::TagInt{3};
+
+    for (auto endianness : {nbtpp2::Endianness::Big, nbtpp2::Endianness::Little}) {
+        auto expected = nbtpp2::BufferWriter{};
+        file.write(expected, endianness, nbtpp2::NbtFile::Compression::None);
+
+        auto writer = nbtpp2::BufferWriter{};
+        nbtpp2::NbtStreamWriter stream{writer, endianness};
+        stream.begin_compound("Level");
+        stream.write_long_array("BlockStates", states.data(), states.size());
+        stream.begin_list("Empty", nbtpp2::TagType::TagEnd, 0);
+        stream.end_list();
+        stream.begin_list("Pos", nbtpp2::TagType::TagDouble, 2);
+        stream.write_double("", 1.5);
+        stream.write_double("", -64.0);
+        stream.end_list();
+        stream.begin_list("Sections", nbtpp2::TagType::TagCompound);
+        for (std::int8_t y : {-4, 5}) {
+            stream.begin_compound("");
+            stream.write_byte("Y", y);
+            stream.end_compound();
+        }
+        stream.end_list();
+        stream.write_int("xPos", 3);
+        REQUIRE(stream.depth() == 1);
+        stream.end_compound();
+        REQUIRE(stream.depth() == 0);
+
+        REQUIRE(std::string(writer.data(), writer.size()) == std::string(expected.data(), expected.size()));
+        REQUIRE_THROWS_AS(stream.write_int("again", 1), std::runtime_error);
+    }
+
+    // Lengths can only be filled in afterwards in a buffer, and must match when given up front
+    auto counter = nbtpp2::CountingWriter{};
+    nbtpp2::NbtStreamWriter counted{counter, nbtpp2::Endianness::Big};
+    counted.begin_compound("");
+    REQUIRE_THROWS_AS(counted.begin_list("List", nbtpp2::TagType::TagInt), std::runtime_error);
+    counted.begin_list("List", nbtpp2::TagType::TagInt, 1);
+    REQUIRE_THROWS_AS(counted.write_short("", 1), std::runtime_error);
+    REQUIRE_THROWS_AS(counted.end_list(), std::runtime_error);
+    REQUIRE_THROWS_AS(counted.end_compound(), std::runtime_error);
+    counted.write_int("", 1);
+    REQUIRE_THROWS_AS(counted.write_int("", 2), std::runtime_error);
+    counted.end_list();
+    counted.end_compound();
+}
+
+TEST_CASE("Patch", "[patch]")
+{
+    auto inflated = inflated_bigtest();
+    auto size = inflated.size();
+
+    nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "longTest", std::int64_t{-42});
+    nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "nested compound test.egg.value", 2.5f);
+    nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "listTest (long)[3]", std::int64_t{7});
+    nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "listTest (compound)[1].created-on",
+                        std::int64_t{1});
+    REQUIRE(inflated.size() == size);
+
+    auto file = nbtpp2::NbtFile{inflated.data(), inflated.size(), nbtpp2::Endianness::Big};
+    auto &root = file.get_root_tag_compound();
+    REQUIRE(root["longTest"]->as<nbtpp2::tags::TagLong>().value == -42);
+    REQUIRE(root["nested compound test"]->as<nbtpp2::tags::TagCompound>().value["egg"]
+                ->as<nbtpp2::tags::TagCompound>().value["value"]->as<nbtpp2::tags::TagFloat>().value == 2.5f);
+    REQUIRE(root["listTest (long)"]->as<nbtpp2::tags::TagList>().value[3]->as<nbtpp2::tags::TagLong>().value == 7);
+    REQUIRE(root["listTest (compound)"]->as<nbtpp2::tags::TagList>().value[1]->as<nbtpp2::tags::TagCompound>()
+                .value["created-on"]->as<nbtpp2::tags::TagLong>().value == 1);
+    REQUIRE(root["intTest"]->as<nbtpp2::tags::TagInt>().value == 2147483647);
+
+    auto location = nbtpp2::locate_value(inflated.data(), size, nbtpp2::Endianness::Big, "shortTest");
+    REQUIRE(location.type == nbtpp2::TagType::TagShort);
+    REQUIRE_THROWS_AS(nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "shortTest", 1),
+                      std::runtime_error);
+    REQUIRE_THROWS_AS(nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "missing", 1),
+                      std::runtime_error);
+    REQUIRE_THROWS_AS(nbtpp2::patch_value(inflated.data(), size, nbtpp2::Endianness::Big, "listTest (long)[5]",
+                                          std::int64_t{1}), std::runtime_error);
+    REQUIRE_THROWS_AS(nbtpp2::locate_value(inflated.data(), size, nbtpp2::Endianness::Big, "longTest[x]"),
+                      std::runtime_error);
+
+    // Files on disk only have the bytes of the number rewritten
+    file.write("patch.nbt", nbtpp2::Endianness::Little, nbtpp2::NbtFile::Compression::None);
+    nbtpp2::patch_file("patch.nbt", nbtpp2::Endianness::Little, "intTest", std::int32_t{5});
+    auto patched = nbtpp2::NbtFile{"patch.nbt", nbtpp2::Endianness::Little};
+    REQUIRE(patched.get_root_tag_compound()["intTest"]->as<nbtpp2::tags::TagInt>().value == 5);
+    REQUIRE(patched.get_root_tag_compound()["longTest"]->as<nbtpp2::tags::TagLong>().value == -42);
+    std::remove("patch.nbt");
+
+    // A truncated file is rejected instead of extended
+    auto double_test = nbtpp2::locate_value(inflated.data(), size, nbtpp2::Endianness::Big, "doubleTest");
+    auto truncated = std::fopen("patch.nbt", "wb");
+    REQUIRE(truncated != nullptr);
+    std::fwrite(inflated.data(), 1, double_test.offset + 4, truncated);
+    std::fclose(truncated);
+    REQUIRE_THROWS_AS(nbtpp2::patch_file("patch.nbt", nbtpp2::Endianness::Big, "doubleTest", 1.0), std::runtime_error);
+    auto reopened = std::fopen("patch.nbt", "rb");
+    std::fseek(reopened, 0, SEEK_END);
+    REQUIRE(static_cast<std::size_t>(std::ftell(reopened)) == double_test.offset + 4);
+    std::fclose(reopened);
+    std::remove("patch.nbt");
+
+    REQUIRE_THROWS_AS(nbtpp2::patch_file("bigtest.nbt", nbtpp2::Endianness::Big, "intTest", std::int32_t{5}),
+                      std::runtime_error);
+}
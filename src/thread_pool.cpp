@@ -0,0 +1,104 @@
+#include <nbtpp2/thread_pool.hpp>
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+/// Pool the current thread is a worker of
+thread_local const ThreadPool *current_pool = nullptr;
+
+/// Queue index of the current worker thread
+thread_local std::size_t current_queue = 0;
+
+}
+
+ThreadPool::ThreadPool(unsigned threads)
+{
+    if (threads == 0) threads = std::thread::hardware_concurrency();
+    if (threads == 0) threads = 1;
+
+    queues.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        queues.emplace_back(new Queue);
+    }
+    workers.reserve(threads);
+    for (unsigned i = 0; i < threads; ++i) {
+        workers.emplace_back(&ThreadPool::work, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        stopping = true;
+    }
+    cv.notify_all();
+    for (auto &worker : workers) {
+        worker.join();
+    }
+}
+
+unsigned ThreadPool::size() const
+{
+    return static_cast<unsigned>(workers.size());
+}
+
+void ThreadPool::push(std::function<void()> job)
+{
+    auto index = current_pool == this ? current_queue : next_queue++ % queues.size();
+    {
+        std::lock_guard<std::mutex> lock{queues[index]->mutex};
+        queues[index]->jobs.push_back(std::move(job));
+    }
+    {
+        std::lock_guard<std::mutex> lock{mutex};
+        ++queued;
+    }
+    cv.notify_one();
+}
+
+std::function<void()> ThreadPool::take(std::size_t index)
+{
+    // The caller has claimed a job, which is already in one of the queues
+    while (true) {
+        {
+            auto &own = *queues[index];
+            std::lock_guard<std::mutex> lock{own.mutex};
+            if (!own.jobs.empty()) {
+                auto job = std::move(own.jobs.back());
+                own.jobs.pop_back();
+                return job;
+            }
+        }
+        for (std::size_t i = 1; i < queues.size(); ++i) {
+            auto &victim = *queues[(index + i) % queues.size()];
+            std::lock_guard<std::mutex> lock{victim.mutex};
+            if (!victim.jobs.empty()) {
+                auto job = std::move(victim.jobs.front());
+                victim.jobs.pop_front();
+                return job;
+            }
+        }
+    }
+}
+
+void ThreadPool::work(std::size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock{mutex};
+            cv.wait(lock, [this]() { return stopping || queued > 0; });
+            if (queued == 0) return;
+            --queued;
+        }
+        take(index)();
+    }
+}
+
+}
@@ -1,20 +1,121 @@
 #include <nbtpp2/util.hpp>
 
+#include <stdexcept>
+
 namespace nbtpp2
 {
 
+namespace
+{
+
+/// Size of the payload of a fixed-size tag type, or 0 for the others
+std::size_t fixed_payload_size(TagType type)
+{
+    switch (type) {
+    case TagType::TagByte: return 1;
+    case TagType::TagShort: return 2;
+    case TagType::TagInt:
+    case TagType::TagFloat: return 4;
+    case TagType::TagLong:
+    case TagType::TagDouble: return 8;
+    default: return 0;
+    }
+}
+
+/// Compound (element_type TagEnd) or list being skipped
+struct SkipFrame
+{
+    TagType element_type;
+    std::int32_t remaining;
+};
+
+template<Endianness E>
+void skip_payload(TagType type, BinaryReader &reader)
+{
+    SkipFrame stack[MAX_SKIP_DEPTH];
+    std::size_t depth = 0;
+    auto push = [&](TagType element_type, std::int32_t remaining)
+    {
+        if (depth == MAX_SKIP_DEPTH) throw std::runtime_error("tags nested too deeply to skip");
+        stack[depth++] = SkipFrame{element_type, remaining};
+    };
+
+    while (true) {
+        switch (type) {
+        case TagType::TagString:
+            reader.skip(read_number<E, std::uint16_t, std::uint16_t>(reader));
+            break;
+        case TagType::TagByteArray:
+        case TagType::TagIntArray:
+        case TagType::TagLongArray: {
+            auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+            if (len < 0) throw std::runtime_error("negative array length");
+            auto element_size = type == TagType::TagByteArray ? 1u : type == TagType::TagIntArray ? 4u : 8u;
+            reader.skip(static_cast<std::size_t>(len) * element_size);
+            break;
+        }
+        case TagType::TagList: {
+            auto element_type = read_tag_id(reader);
+            auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+            if (len <= 0) break;
+            if (element_type == TagType::TagEnd)
+                throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
+            auto element_size = fixed_payload_size(element_type);
+            if (element_size != 0) {
+                reader.skip(static_cast<std::size_t>(len) * element_size);
+                break;
+            }
+            push(element_type, len);
+            break;
+        }
+        case TagType::TagCompound:
+            push(TagType::TagEnd, 0);
+            break;
+        default: {
+            auto size = fixed_payload_size(type);
+            if (size == 0) throw std::runtime_error("tag type not matched");
+            reader.skip(size);
+        }
+        }
+
+        // Find the next tag whose payload is to be skipped
+        type = TagType::TagEnd;
+        while (depth > 0 && type == TagType::TagEnd) {
+            auto &frame = stack[depth - 1];
+            if (frame.element_type == TagType::TagEnd) {
+                type = read_tag_id(reader);
+                if (type == TagType::TagEnd) --depth;
+                else reader.skip(read_number<E, std::uint16_t, std::uint16_t>(reader));
+            }
+            else if (frame.remaining > 0) {
+                --frame.remaining;
+                type = frame.element_type;
+            }
+            else {
+                --depth;
+            }
+        }
+        if (type == TagType::TagEnd) return;
+    }
+}
+
+}
+
 void write_string(const std::string &str, BinaryWriter &writer, Endianness endianness)
 {
-    write_number<std::uint16_t, std::uint16_t>(static_cast<std::uint16_t>(str.size()), writer, endianness);
-    writer.write(str.data(), static_cast<std::uint16_t>(str.size()));
+    if (endianness == Endianness::Big) write_string<Endianness::Big>(str, writer);
+    else write_string<Endianness::Little>(str, writer);
 }
 
 std::string read_string(BinaryReader &reader, Endianness endianness)
 {
-    auto len = read_number<std::uint16_t, std::uint16_t>(reader, endianness);
-    auto res = std::string(len, ' ');
-    reader.read(&res[0], len);
-    return res;
+    return endianness == Endianness::Big ? read_string<Endianness::Big>(reader)
+                                         : read_string<Endianness::Little>(reader);
+}
+
+Key read_key(BinaryReader &reader, Endianness endianness)
+{
+    return endianness == Endianness::Big ? read_key<Endianness::Big>(reader) : read_key<Endianness::Little>(reader);
 }
 
 void write_tag_id(TagType type, BinaryWriter &writer)
@@ -27,6 +128,12 @@ TagType read_tag_id(BinaryReader &reader)
     return read_number<TagType, std::uint8_t>(reader, SYSTEM_ENDIANNESS);
 }
 
+void skip_tag(TagType type, BinaryReader &reader, Endianness endianness)
+{
+    if (endianness == Endianness::Big) skip_payload<Endianness::Big>(type, reader);
+    else skip_payload<Endianness::Little>(type, reader);
+}
+
 std::string tag_type_to_string(TagType tag_type)
 {
     switch (tag_type) {
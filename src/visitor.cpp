@@ -0,0 +1,147 @@
+#include <nbtpp2/visitor.hpp>
+#include <nbtpp2/util.hpp>
+
+#include <vector>
+
+namespace nbtpp2
+{
+
+namespace
+{
+
+/**
+ * Walks a file recursively, reusing its buffers for every name, string and array
+ *
+ * @tparam E Endianness of the file, fixed at compile time like read_tag() so that no field checks it
+ */
+template<Endianness E>
+class VisitParser
+{
+    BinaryReader &reader;
+    BufferReader *buffer_reader;
+    NbtVisitor &visitor;
+
+    std::string name;
+    std::string text;
+    std::vector<std::int8_t> bytes;
+    std::vector<std::int32_t> ints;
+    std::vector<std::int64_t> longs;
+
+    /// Number of compounds and lists being read, bounded like skip_tag() so that hostile files cannot overflow the stack
+    std::size_t depth = 0;
+
+    void enter()
+    {
+        if (++depth > MAX_SKIP_DEPTH) throw std::runtime_error("tags nested too deeply to visit");
+    }
+
+    void read_into(std::string &out)
+    {
+        auto len = read_number<E, std::uint16_t, std::uint16_t>(reader);
+        out.resize(len);
+        reader.read(&out[0], len);
+    }
+
+    std::size_t read_length()
+    {
+        auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+        return len < 0 ? 0 : static_cast<std::size_t>(len);
+    }
+
+    template<typename NumberT, typename NumberTUnsigned>
+    void read_array(std::vector<NumberT> &buffer)
+    {
+        buffer.resize(read_length());
+        read_numbers<NumberT, NumberTUnsigned>(reader, buffer.data(), buffer.size(), E);
+        visitor.array(name, buffer.data(), buffer.size());
+    }
+
+public:
+    VisitParser(BinaryReader &reader, NbtVisitor &visitor)
+        : reader(reader), buffer_reader{dynamic_cast<BufferReader *>(&reader)}, visitor(visitor)
+    {}
+
+    /// Read the payload of a tag named {@link name}
+    void payload(TagType type)
+    {
+        switch (type) {
+        case TagType::TagByte: visitor.value(name, read_number<E, std::int8_t, std::uint8_t>(reader));
+            return;
+        case TagType::TagShort: visitor.value(name, read_number<E, std::int16_t, std::uint16_t>(reader));
+            return;
+        case TagType::TagInt: visitor.value(name, read_number<E, std::int32_t, std::uint32_t>(reader));
+            return;
+        case TagType::TagLong: visitor.value(name, read_number<E, std::int64_t, std::uint64_t>(reader));
+            return;
+        case TagType::TagFloat: visitor.value(name, read_number<E, float, std::uint32_t>(reader));
+            return;
+        case TagType::TagDouble: visitor.value(name, read_number<E, double, std::uint64_t>(reader));
+            return;
+        case TagType::TagString:
+            read_into(text);
+            visitor.value(name, text);
+            return;
+        case TagType::TagByteArray: {
+            auto len = read_length();
+            if (buffer_reader != nullptr) {
+                auto data = buffer_reader->read_ptr(static_cast<std::uint32_t>(len));
+                visitor.array(name, reinterpret_cast<const std::int8_t *>(data), len);
+                return;
+            }
+            bytes.resize(len);
+            reader.read(reinterpret_cast<char *>(bytes.data()), static_cast<std::uint32_t>(len));
+            visitor.array(name, bytes.data(), bytes.size());
+            return;
+        }
+        case TagType::TagIntArray: read_array<std::int32_t, std::uint32_t>(ints);
+            return;
+        case TagType::TagLongArray: read_array<std::int64_t, std::uint64_t>(longs);
+            return;
+        case TagType::TagList: {
+            auto element_type = read_tag_id(reader);
+            auto len = read_number<E, std::int32_t, std::uint32_t>(reader);
+            if (len > 0 && element_type == TagType::TagEnd)
+                throw std::runtime_error("TAG_List with size greater than 0 is not allowed to have type TAG_End");
+            enter();
+            visitor.begin_list(name, element_type, len);
+            for (std::int32_t i = 0; i < len; ++i) {
+                name.clear();
+                payload(element_type);
+            }
+            visitor.end_list();
+            --depth;
+            return;
+        }
+        case TagType::TagCompound:
+            enter();
+            visitor.begin_compound(name);
+            while (true) {
+                auto id = read_tag_id(reader);
+                if (id == TagType::TagEnd) break;
+                read_into(name);
+                payload(id);
+            }
+            visitor.end_compound();
+            --depth;
+            return;
+        default: throw std::runtime_error("tag type not matched");
+        }
+    }
+
+    void root()
+    {
+        auto id = read_tag_id(reader);
+        read_into(name);
+        payload(id);
+    }
+};
+
+}
+
+void visit(BinaryReader &reader, Endianness endianness, NbtVisitor &visitor)
+{
+    if (endianness == Endianness::Big) VisitParser<Endianness::Big>{reader, visitor}.root();
+    else VisitParser<Endianness::Little>{reader, visitor}.root();
+}
+
+}